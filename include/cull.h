@@ -0,0 +1,107 @@
+#pragma once
+
+/*
+ * Visibility culling of bounding volumes against a camera's view frustum
+ *
+ * The cull functions test whole arrays of bounding volumes at once with SIMD, and write the indices of the visible
+ * ones to a compacted list so callers only have to walk what's actually on screen. Tests are conservative: a volume
+ * is only culled if it lies entirely outside of one of the frustum's planes, so a few volumes near the corners of the
+ * frustum may be reported visible without actually being so.
+ */
+
+#include "mathtypes.h"
+
+namespace mkb2
+{
+
+// Forward declarations
+struct StagedefBanana;
+struct StagedefStageModelInstance;
+struct StagedefBackgroundModel;
+
+struct Sphere
+{
+    Vec3f center;
+    f32 radius;
+};
+
+struct Aabb
+{
+    Vec3f min;
+    Vec3f max;
+};
+
+/*
+ * Plane with a unit normal pointing towards its inside. A point is inside if `dot(normal, point) + dist >= 0`.
+ */
+struct Plane
+{
+    Vec3f normal;
+    f32 dist;
+};
+
+/*
+ * Planes bounding a camera's view volume, in the same order as the bits of ClipFlags: left, right, bottom, top, near,
+ * far.
+ */
+struct Frustum
+{
+    Plane planes[6];
+};
+
+/*
+ * Radius of a sphere guaranteed to contain a single banana or banana bunch.
+ */
+constexpr f32 BANANA_CULL_RADIUS = 1.f;
+
+/*
+ * Extract the world-space frustum planes of a combined projection and view matrix, such as one made by
+ * `mtx44_mult_mtx()`.
+ */
+void frustum_from_mtx44(Frustum *out_frustum, Mtx44 *view_proj);
+
+/*
+ * Extract the world-space frustum planes of a camera with projection `proj` and view matrix `view`.
+ */
+void frustum_from_camera(Frustum *out_frustum, Mtx44 *proj, Mtx *view);
+
+/*
+ * Test each of `count` spheres against `frustum`, writing the indices of the visible ones in increasing order to
+ * `out_visible_idxs`. Returns the number of visible spheres.
+ *
+ * `out_visible_idxs` must have room for `count` indices.
+ */
+u32 cull_spheres(Frustum *frustum, Sphere *spheres, u32 count, u32 *out_visible_idxs);
+
+/*
+ * Test each of `count` axis-aligned bounding boxes against `frustum`, like `cull_spheres()`.
+ */
+u32 cull_aabbs(Frustum *frustum, Aabb *aabbs, u32 count, u32 *out_visible_idxs);
+
+/*
+ * Compute world-space bounding spheres of `count` stagedef bananas for `cull_spheres()`.
+ *
+ * `coli_header_mtx` is the current transform of the collision header the bananas belong to, or null if the bananas
+ * are already in world space.
+ */
+void stagedef_banana_spheres(StagedefBanana *bananas, u32 count, Mtx *coli_header_mtx, Sphere *out_spheres);
+
+/*
+ * Compute world-space bounding spheres of `count` stagedef stage model instances for `cull_spheres()`.
+ *
+ * Stagedefs don't contain model bounds, so `model_bounds[i]` must be the model-space bounding sphere of the model
+ * used by `instances[i]`. `coli_header_mtx` is the current transform of the collision header the instances belong
+ * to, or null for none.
+ */
+void stagedef_stage_model_instance_spheres(StagedefStageModelInstance *instances, u32 count, Mtx *coli_header_mtx,
+                                           Sphere *model_bounds, Sphere *out_spheres);
+
+/*
+ * Compute world-space bounding spheres of `count` stagedef background models for `cull_spheres()`.
+ *
+ * `model_bounds[i]` must be the model-space bounding sphere of `models[i]`'s model.
+ */
+void stagedef_background_model_spheres(StagedefBackgroundModel *models, u32 count, Sphere *model_bounds,
+                                       Sphere *out_spheres);
+
+}
\ No newline at end of file
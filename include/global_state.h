@@ -27,31 +27,39 @@ namespace mkb2
 // Number of matrices on the matrix stack, actual size currently unknown
 constexpr u32 MTX_STACK_LEN = 128;
 
+// Number of Matrix A operations buffered in deferred mode before they're applied
+constexpr u32 MTXA_OP_BUFFER_LEN = 16;
+
+enum MtxaOpType : u8
+{
+    MTXA_OP_TRANSLATE,
+    MTXA_OP_SCALE,
+    MTXA_OP_ROTATE_X,
+    MTXA_OP_ROTATE_Y,
+    MTXA_OP_ROTATE_Z,
+};
+
+/*
+ * A transform applied to Matrix A in deferred mode, see `mtxa_set_deferred()`.
+ */
+struct MtxaOp
+{
+    MtxaOpType type;
+    s16 angle; // Rotations only
+    Vec3f vec; // Translations and scales only
+};
+
 // TODO order data in MKB2 memory order and label memory addresses
 struct GlobalState
 {
     Event events[NUM_EVENTS];
 
-    Ball balls[MAX_BALLS];
-    Item items[MAX_ITEMS];
-    Stobj stobjs[MAX_STOBJS];
-    Sprite sprites[MAX_SPRITES];
-    Effect effects[MAX_EFFECTS];
-    Camera cameras[MAX_CAMERAS];
-
-    u8 ball_status_list[MAX_BALLS];
-    u8 item_status_list[MAX_ITEMS];
-    u8 stobj_status_list[MAX_STOBJS];
-    u8 sprite_status_list[MAX_SPRITES];
-    u8 effect_status_list[MAX_EFFECTS];
-    u8 camera_status_list[MAX_CAMERAS];
-
-    PoolInfo ball_pool_info;
-    PoolInfo item_pool_info;
-    PoolInfo stobj_pool_info;
-    PoolInfo sprite_pool_info;
-    PoolInfo effect_pool_info;
-    PoolInfo camera_pool_info;
+    ArenaPool<Ball> ball_pool;
+    ArenaPool<Item> item_pool;
+    ArenaPool<Stobj> stobj_pool;
+    ArenaPool<Sprite> sprite_pool;
+    ArenaPool<Effect> effect_pool;
+    ArenaPool<Camera> camera_pool;
 
     // Sometimes read by the game directly, usually mtxa/mtxb only written to with `math_` functions though
     Mtx *mtxa = &mtxa_raw;
@@ -60,17 +68,68 @@ struct GlobalState
      * Data originally stored in the locked cache, starting at 0xE0000000
      */
 
-    Mtx mtxa_raw;
-    Mtx mtxb_raw;
-    Mtx mtx_stack[MTX_STACK_LEN]; // Location in locked cache currently unknown
+    // 16-byte aligned (unlike in the original game) so the math library can access them with aligned SIMD loads
+    alignas(16) Mtx mtxa_raw;
+    alignas(16) Mtx mtxb_raw;
+    alignas(16) Mtx mtx_stack[MTX_STACK_LEN]; // Location in locked cache currently unknown
     Mtx *mtx_stack_ptr = mtx_stack + MTX_STACK_LEN;
+
+    /*
+     * Not in the original game
+     */
+
+    // Matrix A operations not yet applied to `mtxa_raw`, see `mtxa_set_deferred()`
+    bool mtxa_deferred = false;
+    u32 mtxa_op_count = 0;
+    MtxaOp mtxa_ops[MTXA_OP_BUFFER_LEN];
+
+    // Object pool sizes, and the size of the arena directly after this struct holding the pools' objects and statuses.
+    // Only set by `global_state_create()`, which allocates the arena to fit the capacities
+    PoolCapacities get_pool_capacities() { return pool_capacities; }
+    u32 get_pool_arena_size() { return pool_arena_size; }
+
+    // Allocated along with its zeroed pool arena, which is freed with it. A GlobalState without an arena has no room
+    // for its pools, so there's no plain `new GlobalState()`
+    static void *operator new(size_t size, u32 arena_size);
+    static void *operator new(size_t size) = delete;
+    static void operator delete(void *ptr);
+
+private:
+    PoolCapacities pool_capacities = VANILLA_POOL_CAPACITIES;
+    u32 pool_arena_size = 0;
+
+    friend std::unique_ptr<GlobalState> global_state_create(PoolCapacities pool_capacities);
 };
 
 /*
  * The current instance of GlobalState used by libmkb.
  *
- * Statically-initialized to an instance by default.
+ * Statically-initialized to an instance with the original game's pool capacities by default.
  */
 extern std::unique_ptr<GlobalState> gs;
 
+/*
+ * Create a GlobalState whose object pools have the given capacities, such as the original game's
+ * `VANILLA_POOL_CAPACITIES`. The pools are stored in an arena allocated along with the GlobalState.
+ *
+ * A GlobalState must only be copied with `global_state_snapshot()` and `global_state_restore()`. A plain copy
+ * (`GlobalState copy = *gs;`) only copies `sizeof(GlobalState)` bytes, leaving the copy's pools pointing past its end
+ * into memory it doesn't own.
+ *
+ * `pool_init()` must be called after making it the current instance.
+ */
+std::unique_ptr<GlobalState> global_state_create(PoolCapacities pool_capacities);
+
+/*
+ * Copy `state` along with its pool arena into a new GlobalState.
+ */
+std::unique_ptr<GlobalState> global_state_snapshot(GlobalState *state);
+
+/*
+ * Overwrite `state` and its pool arena with `snapshot`, which must be a GlobalState with the same pool capacities.
+ *
+ * Returns false without modifying `state` if the capacities differ.
+ */
+bool global_state_restore(GlobalState *state, GlobalState *snapshot);
+
 }
\ No newline at end of file
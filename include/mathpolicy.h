@@ -0,0 +1,83 @@
+/*
+ * Math precision/performance policies
+ * ===================================
+ *
+ * The math library's scalar primitives (square roots, reciprocal square roots, and s16 trig) can be computed in a few
+ * different ways, trading faithfulness to the original game for speed. A policy bundles one choice for each:
+ *
+ * MathPolicyAccurate: Reproduce the original game's results as closely as possible: s16 trig via a sine table
+ *                     indexed by angle, and reciprocal square roots via an emulation of the GameCube's `frsqrte`
+ *                     estimate refined in double precision.
+ * MathPolicyFast: Table-driven trig like the accurate policy, but reciprocal square roots via the SSE `rsqrtps`
+ *                 estimate with a single Newton-Raphson step.
+ * MathPolicyReference: libm, exactly like libmkb before math policies were introduced: trig in double precision
+ *                      rounded to f32, and square roots as `sqrtf()` and `1 / sqrtf()` of the input rounded to f32.
+ *
+ * The policy used by the math library is chosen at build time with the LIBMKB_MATH_POLICY CMake option and is
+ * available as `MathPolicy`. The default is the reference policy, since the accurate policy's `frsqrte` emulation
+ * hasn't been verified against real hardware yet. Every policy's `MathCore` is compiled into the library so they can be
+ * compared side-by-side, but the `math_` functions in mathutil.h are bound to `MathCore<MathPolicy>` directly, so the
+ * unselected policies cost nothing at runtime.
+ */
+
+#pragma once
+
+#include "mathtypes.h"
+
+namespace mkb2
+{
+
+enum RsqrtMode
+{
+    RSQRT_GEKKO,  // Emulated `frsqrte` estimate with three Newton-Raphson steps, like the original game
+    RSQRT_FAST,   // SSE estimate with one Newton-Raphson step (`1 / sqrtf(x)` without SSE)
+    RSQRT_LIBM,   // `1 / sqrtf(x)` of `x` rounded to f32
+};
+
+struct MathPolicyAccurate
+{
+    static constexpr bool TRIG_TABLE = true;
+    static constexpr RsqrtMode RSQRT = RSQRT_GEKKO;
+};
+
+struct MathPolicyFast
+{
+    static constexpr bool TRIG_TABLE = true;
+    static constexpr RsqrtMode RSQRT = RSQRT_FAST;
+};
+
+struct MathPolicyReference
+{
+    static constexpr bool TRIG_TABLE = false;
+    static constexpr RsqrtMode RSQRT = RSQRT_LIBM;
+};
+
+#if defined(LIBMKB_MATH_POLICY_ACCURATE)
+using MathPolicy = MathPolicyAccurate;
+#elif defined(LIBMKB_MATH_POLICY_FAST)
+using MathPolicy = MathPolicyFast;
+#else
+using MathPolicy = MathPolicyReference;
+#endif
+
+/*
+ * The policy-dependent math primitives. See the `math_` function of the same name in mathutil.h for documentation.
+ */
+template <typename Policy>
+struct MathCore
+{
+    static f32 sqrt(f64 x);
+    static f32 rsqrt(f64 x);
+    static f32 sqrt_rsqrt(f64 x, f32 *out_sqrt);
+    static f32 sin(s16 angle);
+    static void sin_cos_v(s16 angle, f32 *out_sin_cos);
+    static f32 tan(s16 angle);
+    static s16 atan2(f64 y, f64 x);
+    static s16 atan(f64 x);
+};
+
+extern template struct MathCore<MathPolicyAccurate>;
+extern template struct MathCore<MathPolicyFast>;
+extern template struct MathCore<MathPolicyReference>;
+
+}
\ No newline at end of file
@@ -44,9 +44,30 @@ struct Vec3s
     s16 z;
 };
 
+/*
+ * Structure-of-arrays view of a sequence of Vec3f, with each component in its own array.
+ */
+struct Vec3fSoa
+{
+    f32 *x;
+    f32 *y;
+    f32 *z;
+};
+
 typedef f32 Mtx[3][4];
 typedef f32 Mtx44[4][4];
 
+/*
+ * Rectangle of the screen that projected points are mapped to, in pixels with Y pointing down.
+ */
+struct Viewport
+{
+    f32 left;
+    f32 top;
+    f32 width;
+    f32 height;
+};
+
 struct Quat
 {
     f32 x;
@@ -55,4 +76,36 @@ struct Quat
     f32 w;
 };
 
+/*
+ * 16-byte aligned companions to the game's vector and matrix types, so SIMD code can use aligned loads and stores.
+ *
+ * These are not part of the game's ABI; game structures keep using Vec3f and Mtx. Vec3fA is a Vec3f padded to a
+ * full SIMD register. AlignedMtx wraps a Mtx, which is already a multiple of 16 bytes, so `m` can be passed anywhere a
+ * Mtx is expected and an array of AlignedMtx has the same layout as an array of Mtx.
+ */
+struct alignas(16) Vec3fA
+{
+    f32 x;
+    f32 y;
+    f32 z;
+    f32 pad; // Unspecified after being written by a math function
+};
+
+struct alignas(16) Vec4f
+{
+    f32 x;
+    f32 y;
+    f32 z;
+    f32 w;
+};
+
+struct alignas(16) AlignedMtx
+{
+    Mtx m;
+};
+
+static_assert(sizeof(Vec3fA) == 16);
+static_assert(sizeof(Vec4f) == 16);
+static_assert(sizeof(AlignedMtx) == sizeof(Mtx));
+
 }
\ No newline at end of file
@@ -25,16 +25,33 @@
  * were applied to the matrix (because in matrix-vector multiplication, the matrix is on the left and the vector
  * is on the right). Just something to keep in mind when browsing the game's codebase.
  *
+ * Matrix A can optionally be put in a deferred mode with `mtxa_set_deferred()`. In this mode, translations, scales,
+ * and single-axis rotations are recorded instead of being applied immediately, and the recorded operations are
+ * applied in one pass the next time any `mtxa_` function reads Matrix A or copies it somewhere. Results are
+ * identical to the default eager mode. Code reading Matrix A directly through `gs->mtxa` or `gs->mtxa_raw` must call
+ * `mtxa_flush()` first.
+ *
  * Vectors
  * -------
  *
  * The canonical datatype for representing 3D vectors is Vec3f. Some functions take Vec3f, while others take (x, y, z)
  * f32 values directly.
  *
+ * Vec3fA, Vec4f, and AlignedMtx are 16-byte aligned companions to Vec3f and Mtx for SIMD code. They aren't used by the
+ * game itself, but the hottest functions have overloads accepting them.
+ *
  * Some functions are otherwise the same but either take a `point` or a `vec` as input. The difference is that `point`
  * means a position in 3D space that is affected by translations, while `vec` means a vector: not affected by
  * translation, but are affected by rotations and scales, for example.
  *
+ * Projection
+ * ----------
+ *
+ * Projection matrices are represented by the Mtx44 type (float[4][4]) and follow the GameCube's conventions: the camera
+ * looks down -Z, and the view volume in clip space is -w <= x, y <= w and -w <= z <= 0. They're usually combined with
+ * a view matrix with `mtx44_mult_mtx()`, then used to project many points to the screen at once with
+ * `mtx44_project_points()`.
+ *
  * Rotations
  * ---------
  *
@@ -51,12 +68,14 @@
  *
  * `mtxa` / `mtxb`: Uses Matrix A or Matrix B in some form
  * `mtx`: Operates on a plain Mtx type
+ * `mtx44`: Operates on a 4x4 Mtx44 projection matrix
  * `from`: Initializes the thing on the left using the thing on the right
  * `to`: Initializes the thing on the right using the thing on the left
  * `tf`: Transform
  * `inv_tf`: Inverse transform
  * `mult`: Involves multiplying two matrices or two quaternions
  * `rigid`: Assumes Matrix A is a rigid transform, a.k.a. only rotation+translation. Faster than non-`rigid` version
+ * `uniform_scale`: Assumes Matrix A is only rotation+uniform scale+translation. Faster than the general version
  * `vec`: Vector
  * `ray`: Directed line segment denoted by a start point and end point
  * `dir`: Direction, a.k.a. normalized vector
@@ -74,6 +93,45 @@
 namespace mkb2
 {
 
+/*
+ * Order in which the axis rotations of a Vec3s rotation are applied to a matrix.
+ *
+ * For example, EULER_ORDER_ZYX is equivalent to `mtxa_rotate_z()`, then `mtxa_rotate_y()`, then `mtxa_rotate_x()`,
+ * which is the order the game uses for most stagedef objects.
+ */
+enum EulerOrder
+{
+    EULER_ORDER_XYZ,
+    EULER_ORDER_XZY,
+    EULER_ORDER_YXZ,
+    EULER_ORDER_YZX,
+    EULER_ORDER_ZXY,
+    EULER_ORDER_ZYX,
+};
+
+/*
+ * How `quat_slerp_batch()` interpolates.
+ */
+enum SlerpMode
+{
+    SLERP_EXACT, // Identical results to `quat_slerp()`
+    SLERP_FAST,  // Identical results to `quat_nlerp()`
+};
+
+/*
+ * Bits set in the clip flags of a point projected by `mtx44_project_points()`, one for each side of the view volume
+ * the point lies outside of.
+ */
+enum ClipFlags
+{
+    CLIP_LEFT = 1 << 0,
+    CLIP_RIGHT = 1 << 1,
+    CLIP_BOTTOM = 1 << 2,
+    CLIP_TOP = 1 << 3,
+    CLIP_NEAR = 1 << 4,
+    CLIP_FAR = 1 << 5,
+};
+
 /*
  * Initializes the math library.
  */
@@ -90,6 +148,9 @@ f32 math_sqrt(f64 x);
  * Computes the reciprocal square-root of `x` (`1/sqrt(x)`).
  *
  * Returns INFINITY if `x` is non-positive.
+ *
+ * The implementation is chosen at build time by the math policy (see mathpolicy.h). The same choice applies to every
+ * function which normalizes vectors or quaternions.
  */
 f32 math_rsqrt(f64 x);
 
@@ -101,6 +162,13 @@ f32 math_rsqrt(f64 x);
  */
 f32 math_sqrt_rsqrt(f64 x, f32 *out_sqrt);
 
+/*
+ * Emulates the GameCube CPU's `frsqrte` instruction: a reciprocal square-root estimate accurate to about 1/4096.
+ *
+ * Returns INFINITY for 0, 0 for INFINITY, and NAN for negative values.
+ */
+f64 math_frsqrte(f64 x);
+
 /*
  * Computes the sine of `angle`.
  */
@@ -166,6 +234,51 @@ f32 vec_normalize_len(Vec3f *vec);
  */
 f32 vec_dot_normalized(Vec3f *vec1, Vec3f *vec2);
 
+/*
+ * Normalizes each of `count` vectors in place like `vec_normalize_len()`, writing their original lengths to
+ * `out_lens` unless it's null.
+ *
+ * The `_batch` versions of the bulk vector functions take arrays of Vec3f and the `_soa` versions take separate
+ * x/y/z arrays. Both produce identical results to calling the single-vector function on each vector, including for
+ * zero, INFINITY, and NAN inputs.
+ */
+void vec_normalize_len_batch(Vec3f *vecs, f32 *out_lens, u32 count);
+void vec_normalize_len_soa(Vec3fSoa *vecs, f32 *out_lens, u32 count);
+
+/*
+ * Sets the length of each of `count` vectors like `vec_set_len()`, writing them to `out_vecs`.
+ *
+ * `out_vecs` may be the same as `vecs`.
+ */
+void vec_set_len_batch(f32 len, Vec3f *vecs, Vec3f *out_vecs, u32 count);
+void vec_set_len_soa(f32 len, Vec3fSoa *vecs, Vec3fSoa *out_vecs, u32 count);
+
+/*
+ * Computes `vec_dot_normalized()` of each of `count` pairs of vectors, writing the results to `out_dots`.
+ */
+void vec_dot_normalized_batch(Vec3f *vecs1, Vec3f *vecs2, f32 *out_dots, u32 count);
+void vec_dot_normalized_soa(Vec3fSoa *vecs1, Vec3fSoa *vecs2, f32 *out_dots, u32 count);
+
+/*
+ * Computes `vec_dot_normalized_safe()` of each of `count` pairs of vectors, writing the results to `out_dots`.
+ */
+void vec_dot_normalized_safe_batch(Vec3f *vecs1, Vec3f *vecs2, f32 *out_dots, u32 count);
+void vec_dot_normalized_safe_soa(Vec3fSoa *vecs1, Vec3fSoa *vecs2, f32 *out_dots, u32 count);
+
+/*
+ * Enable or disable deferred mode for Matrix A (disabled by default).
+ *
+ * In deferred mode, `mtxa_translate*()`, `mtxa_scale*()`, and `mtxa_rotate_x/y/z()` are recorded and applied to
+ * Matrix A in one pass when it's next read, with results identical to applying them immediately. Disabling deferred
+ * mode applies any pending operations.
+ */
+void mtxa_set_deferred(bool deferred);
+
+/*
+ * Apply any Matrix A operations pending from deferred mode, so that `gs->mtxa` can be read directly.
+ */
+void mtxa_flush();
+
 /*
  * Sets Matrix A to the identity matrix.
  */
@@ -283,9 +396,26 @@ void mtx_copy(Mtx *src, Mtx *dst);
 
 /*
  * Invert Matrix A.
+ *
+ * Works for any invertible affine transform. If Matrix A is known to be rigid or to only have a uniform scale,
+ * `mtxa_rigid_invert()` or `mtxa_uniform_scale_invert()` are cheaper.
  */
 void mtxa_invert();
 
+/*
+ * Invert Matrix A, assuming Matrix A is a rigid transformation.
+ *
+ * Equivalent to `mtxa_transpose()`. In debug builds, asserts that Matrix A is actually rigid.
+ */
+void mtxa_rigid_invert();
+
+/*
+ * Invert Matrix A, assuming Matrix A only consists of a rotation, a uniform scale, and a translation.
+ *
+ * In debug builds, asserts that Matrix A's basis vectors are actually orthogonal and of equal length.
+ */
+void mtxa_uniform_scale_invert();
+
 /*
  * Transpose Matrix A.
  *
@@ -321,6 +451,25 @@ void mtxa_from_mtxb_mult_mtx(Mtx *mtx);
  */
 void mtx_mult(Mtx *mtx1, Mtx *mtx2, Mtx *dst);
 
+/*
+ * Multiply each of `count` matrices in `children` on the left by `parent`, writing the results to `out_mtxs`.
+ *
+ * out_mtxs[i] = parent * children[i]
+ *
+ * Produces identical results to calling `mtx_mult()` on each matrix. `children` and `out_mtxs` may be the same array.
+ */
+void mtx_mult_batch(Mtx *parent, Mtx *children, Mtx *out_mtxs, u32 count);
+
+/*
+ * Multiply each of `count` matrices in `children` on the left by its own parent, writing the results to `out_mtxs`.
+ *
+ * out_mtxs[i] = parents[parent_idxs[i]] * children[i]
+ *
+ * Produces identical results to calling `mtx_mult()` on each matrix. `children` and `out_mtxs` may be the same array,
+ * but `parents` must not overlap `out_mtxs`.
+ */
+void mtx_mult_batch_indexed(Mtx *parents, u32 *parent_idxs, Mtx *children, Mtx *out_mtxs, u32 count);
+
 /*
  * Apply a translation transform to Matrix A on the right side.
  *
@@ -418,6 +567,22 @@ void mtxa_tf_point_xyz(f32 x, f32 y, f32 z, Vec3f *dst);
  */
 void mtxa_tf_vec_xyz(f32 x, f32 y, f32 z, Vec3f *dst);
 
+/*
+ * Transform an array of `count` Vec3f points by Matrix A.
+ *
+ * Produces identical results to calling `mtxa_tf_point()` on each point, but processes several points at once
+ * with SIMD. `src` and `dst` may be the same array.
+ */
+void mtxa_tf_points(Vec3f *src, Vec3f *dst, u32 count);
+
+/*
+ * Transform an array of `count` Vec3f vectors by Matrix A.
+ *
+ * Produces identical results to calling `mtxa_tf_vec()` on each vector, but processes several vectors at once
+ * with SIMD. `src` and `dst` may be the same array.
+ */
+void mtxa_tf_vecs(Vec3f *src, Vec3f *dst, u32 count);
+
 /*
  * Transform a point by the inverse of Matrix A, assuming Matrix A is a rigid transformation.
  *
@@ -432,6 +597,15 @@ void mtxa_rigid_inv_tf_point(Vec3f *src, Vec3f *dst);
  */
 void mtxa_rigid_inv_tf_point_xyz(f32 x, f32 y, f32 z, Vec3f *dst);
 
+/*
+ * Transform an array of `count` Vec3f points by the inverse of Matrix A, assuming Matrix A is a rigid transformation.
+ *
+ * Useful for bringing many points into the local space of a single transform, for example ball positions into the
+ * space of an animated collision header. Produces identical results to calling `mtxa_rigid_inv_tf_point()` on each
+ * point. `src` and `dst` may be the same array.
+ */
+void mtxa_rigid_inv_tf_points(Vec3f *src, Vec3f *dst, u32 count);
+
 /*
  * Transform the vector given by Matrix A's translation column
  * by the inverse of Matrix A, assuming Matrix A is a rigid transformation.
@@ -456,6 +630,47 @@ void mtxa_rigid_inv_tf_vec(Vec3f *src, Vec3f *dst);
  */
 void mtxa_rigid_inv_tf_vec_xyz(f32 x, f32 y, f32 z, Vec3f *dst);
 
+/*
+ * Transform an array of `count` Vec3f vectors by the inverse of Matrix A, assuming Matrix A is a rigid
+ * transformation.
+ *
+ * Produces identical results to calling `mtxa_rigid_inv_tf_vec()` on each vector. `src` and `dst` may be the same
+ * array.
+ */
+void mtxa_rigid_inv_tf_vecs(Vec3f *src, Vec3f *dst, u32 count);
+
+/*
+ * Convert between Vec3f and its 16-byte aligned companion Vec3fA.
+ */
+inline Vec3fA vec3fa_from_vec3f(Vec3f *vec)
+{
+    return {vec->x, vec->y, vec->z, 0.f};
+}
+
+inline Vec3f vec3fa_to_vec3f(Vec3fA *vec)
+{
+    return {vec->x, vec->y, vec->z};
+}
+
+/*
+ * Overloads of the functions above for the 16-byte aligned types.
+ *
+ * These produce identical results to the Vec3f and Mtx versions, but use aligned SIMD loads and stores, and transform
+ * one vector at a time in SIMD registers instead of one component at a time. The `pad` component of output Vec3fA's
+ * is unspecified.
+ */
+void mtxa_to_mtx(AlignedMtx *mtx);
+void mtxa_from_mtx(AlignedMtx *mtx);
+void mtxa_mult_right(AlignedMtx *mtx);
+void mtxa_mult_left(AlignedMtx *mtx);
+void mtx_mult(AlignedMtx *mtx1, AlignedMtx *mtx2, AlignedMtx *dst);
+void mtxa_tf_point(Vec3fA *src, Vec3fA *dst);
+void mtxa_tf_vec(Vec3fA *src, Vec3fA *dst);
+void mtxa_tf_points(Vec3fA *src, Vec3fA *dst, u32 count);
+void mtxa_tf_vecs(Vec3fA *src, Vec3fA *dst, u32 count);
+void mtxa_rigid_inv_tf_point(Vec3fA *src, Vec3fA *dst);
+void mtxa_rigid_inv_tf_vec(Vec3fA *src, Vec3fA *dst);
+
 /*
  * Apply an X rotation to Matrix A.
  *
@@ -477,6 +692,88 @@ void mtxa_rotate_y(s16 angle);
  */
 void mtxa_rotate_z(s16 angle);
 
+/*
+ * Initialize `out_mtx` to a perspective projection.
+ *
+ * `fov_y` is the full vertical field of view, `aspect` is the viewport's width divided by its height, and `z_near` and
+ * `z_far` are the (positive) distances to the near and far clip planes.
+ */
+void mtx44_from_perspective(Mtx44 *out_mtx, s16 fov_y, f32 aspect, f32 z_near, f32 z_far);
+
+/*
+ * Initialize `out_mtx` to an orthographic projection of the given view-space box.
+ *
+ * `z_near` and `z_far` are the (positive) distances to the near and far clip planes.
+ */
+void mtx44_from_ortho(Mtx44 *out_mtx, f32 top, f32 bottom, f32 left, f32 right, f32 z_near, f32 z_far);
+
+/*
+ * Assign `dst` to the matrix product of `mtx44` and the affine `mtx`, with `mtx` extended by a (0, 0, 0, 1) row.
+ *
+ * Typically used to combine a projection matrix with a view matrix. `dst` may be the same matrix as `mtx44`.
+ */
+void mtx44_mult_mtx(Mtx44 *mtx44, Mtx *mtx, Mtx44 *dst);
+
+/*
+ * Project `point` to the screen by `mtx44` and return its clip flags (see ClipFlags).
+ *
+ * The screen position in `viewport` is written to the X and Y of `out_screen_point`, and the normalized depth (-1 at
+ * the near plane and 0 at the far plane) to its Z. These are only meaningful when the point isn't clipped by the near
+ * plane: points behind the camera project to mirrored positions.
+ */
+u8 mtx44_project_point(Mtx44 *mtx44, Viewport *viewport, Vec3f *point, Vec3f *out_screen_point);
+
+/*
+ * Project an array of `count` points to the screen like `mtx44_project_point()`, writing their clip flags to
+ * `out_clip_flags`.
+ *
+ * Produces identical results to calling `mtx44_project_point()` on each point, but processes several points at once
+ * with SIMD. `points` and `out_screen_points` may be the same array.
+ */
+void mtx44_project_points(Mtx44 *mtx44, Viewport *viewport, Vec3f *points, Vec3f *out_screen_points,
+                          u8 *out_clip_flags, u32 count);
+
+/*
+ * Initialize `out_mtx` from a translation, a rotation applied in the given order, and a scale.
+ *
+ * Equivalent to `mtxa_from_translate(translate)`, followed by the rotations of `rot` in `order`, followed by
+ * `mtxa_scale(scale)`, but computed in one pass without touching Matrix A.
+ */
+void mtx_from_trs(Mtx *out_mtx, Vec3f *translate, Vec3s *rot, Vec3f *scale, EulerOrder order);
+
+/*
+ * Initialize Matrix A from a translation, a rotation applied in the given order, and a scale.
+ *
+ * See `mtx_from_trs()`.
+ */
+void mtxa_from_trs(Vec3f *translate, Vec3s *rot, Vec3f *scale, EulerOrder order);
+
+/*
+ * Compute the transform of each object in an array of `count` objects, writing them to `out_mtxs`.
+ *
+ * Works with any object type which has `position`, `rotation`, and `scale` members, such as StagedefBumper,
+ * StagedefJamabar, StagedefConeCollision, StagedefStageModelInstance, and StagedefBackgroundModel. Matrix A is not
+ * modified.
+ */
+template <typename T>
+void mtx_from_trs_batch(T *objs, Mtx *out_mtxs, u32 count, EulerOrder order)
+{
+    for (u32 i = 0; i < count; i++)
+    {
+        mtx_from_trs(&out_mtxs[i], &objs[i].position, &objs[i].rotation, &objs[i].scale, order);
+    }
+}
+
+/*
+ * Compute a rotation matrix for each of `count` Euler rotations, applied in the given order, writing them to
+ * `out_mtxs`.
+ *
+ * Translations are set to 0. Results are identical to `mtx_from_trs()` with no translation and a scale of 1, and equal
+ * to `mtxa_from_identity()` followed by the corresponding `mtxa_rotate_x/y/z()` calls up to the sign of zero elements.
+ * Useful for precomputing matrices of static stage objects at load time. Matrix A is not modified.
+ */
+void mtx_from_euler_batch(Vec3s *rots, Mtx *out_mtxs, u32 count, EulerOrder order);
+
 /*
  * Initialize Matrix A from a rotation quaternion.
  *
@@ -484,6 +781,13 @@ void mtxa_rotate_z(s16 angle);
  */
 void mtxa_from_quat(Quat *quat);
 
+/*
+ * Initialize each of `count` matrices in `out_mtxs` from the rotation quaternion at the same index in `quats`.
+ *
+ * Produces identical results to calling `mtxa_from_quat()` on each quaternion. Matrix A is not modified.
+ */
+void mtx_from_quat_batch(Quat *quats, Mtx *out_mtxs, u32 count);
+
 /*
  * Multiply two quaternions.
  *
@@ -491,6 +795,13 @@ void mtxa_from_quat(Quat *quat);
  */
 void quat_mult(Quat *dst, Quat *left, Quat *right);
 
+/*
+ * Multiply `count` pairs of quaternions: dst[i] = left[i] * right[i].
+ *
+ * Produces identical results to calling `quat_mult()` on each pair. `dst` may be the same array as `left` or `right`.
+ */
+void quat_mult_batch(Quat *dst, Quat *left, Quat *right, u32 count);
+
 /*
  * Initialize a rotation quaternion from Matrix A.
  */
@@ -514,9 +825,20 @@ double quat_to_axis_angle(Quat *quat, Vec3f *out_axis);
 void quat_normalize(Quat *quat);
 
 /*
- * Compute the quaternion rotation between two directions (normalized vectors).
+ * Normalize each of `count` quaternions.
  *
- * TODO implement and document behavior when non-normalized vectors are passed in
+ * Produces identical results to calling `quat_normalize()` on each quaternion.
+ */
+void quat_normalize_batch(Quat *quats, u32 count);
+
+/*
+ * Compute the shortest-arc quaternion rotation between the directions of two vectors.
+ *
+ * The vectors don't need to be normalized, only their directions are used. If they point in opposite directions, the
+ * result is a 180 degree rotation about an arbitrary axis perpendicular to `start`. If either vector has zero length,
+ * the result is the identity quaternion.
+ *
+ * The original game's function has peculiar behavior for non-normalized vectors which isn't reproduced here.
  */
 void quat_from_dirs(Quat *out_quat, Vec3f *start, Vec3f *end);
 
@@ -525,6 +847,21 @@ void quat_from_dirs(Quat *out_quat, Vec3f *start, Vec3f *end);
  */
 void quat_slerp(f32 t, Quat *dst, Quat *quat1, Quat *quat2);
 
+/*
+ * Quaternion normalized linear interpolation, along the shortest arc.
+ *
+ * Cheaper than `quat_slerp()` and has the same endpoints, but the rotation speed isn't constant over `t`.
+ */
+void quat_nlerp(f32 t, Quat *dst, Quat *quat1, Quat *quat2);
+
+/*
+ * Interpolate `count` pairs of quaternions with the same `t`: dst[i] = slerp(t, quat1[i], quat2[i]).
+ *
+ * `mode` selects between `quat_slerp()` and the cheaper `quat_nlerp()`; either way, the results are identical to
+ * calling that function on each pair. `dst` may be the same array as `quat1` or `quat2`.
+ */
+void quat_slerp_batch(f32 t, Quat *dst, Quat *quat1, Quat *quat2, u32 count, SlerpMode mode);
+
 /*
  * Compute a Vec3s Euler rotation from a ray direction.
  *
@@ -559,4 +896,9 @@ void mtxa_to_euler_yxz(s16 *out_rot_y, s16 *out_rot_x, s16 *out_rot_z);
  */
 void mtxa_to_euler(Vec3s *out_rot);
 
+/*
+ * Compute a Vec3s Euler rotation from the rotation of each of `count` matrices, like `mtxa_to_euler()`.
+ */
+void mtx_to_euler_batch(Mtx *mtxs, Vec3s *out_rots, u32 count);
+
 }
\ No newline at end of file
@@ -1,7 +1,13 @@
 #pragma once
 
+#include <cassert>
+
 #include "mathtypes.h"
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 namespace mkb2
 {
 
@@ -12,25 +18,268 @@ constexpr u32 MAX_SPRITES = 80;
 constexpr u32 MAX_EFFECTS = 512;
 constexpr u32 MAX_CAMERAS = 5;
 
+// Number of words in the free bitmap of a pool with `len` slots
+constexpr u32 pool_bitmap_len(u32 len)
+{
+    return (len + 63) / 64;
+}
+
+// Index of the lowest set bit of `bits`, which must be nonzero
+inline u32 bitmap_ctz(uint64_t bits)
+{
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanForward64(&idx, bits);
+    return idx;
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+// Bits of word `word` of a free bitmap which correspond to actual slots of a pool with `len` slots
+inline uint64_t bitmap_slot_mask(u32 len, u32 word)
+{
+    u32 slots = len - word * 64;
+    return slots >= 64 ? ~(uint64_t) 0 : ((uint64_t) 1 << slots) - 1;
+}
+
 struct PoolInfo
 {
     u32 len;
     u32 low_free_idx;
     u32 upper_bound;
-    u8 *status_list;
+
+    // Read-only: unlike in the original game, statuses must only be changed through the pool functions so the free
+    // bitmap and the fields below stay up to date
+    const u8 *status_list;
+
+    // Not in the original game: bit (i % 64) of word (i / 64) is set if slot i is free. Bits past `len` are never set
+    uint64_t *free_bitmap;
+
+    // Not in the original game: the lowest free slot, or `len` if there are none
+    u32 lowest_free;
+
+    // Not in the original game: one past the highest live slot, or 0 if there are none
+    u32 live_end;
 };
 
-// Initialize all object pools
+/*
+ * Number of slots of each of the object pools of a GlobalState, see `global_state_create()`.
+ */
+struct PoolCapacities
+{
+    u32 balls;
+    u32 items;
+    u32 stobjs;
+    u32 sprites;
+    u32 effects;
+    u32 cameras;
+};
+
+// The original game's pool sizes
+constexpr PoolCapacities VANILLA_POOL_CAPACITIES = {
+    MAX_BALLS, MAX_ITEMS, MAX_STOBJS, MAX_SPRITES, MAX_EFFECTS, MAX_CAMERAS,
+};
+
+// Initialize all object pools with the capacities of the current GlobalState
 void pool_init();
 
-// Refresh metadata on all object pools
+// Number of arena bytes needed after a GlobalState for pools with the given capacities
+u32 pool_arena_size(PoolCapacities *capacities);
+
+// Refresh metadata on all object pools.
+// Copied from the lowest free slot and live end kept up to date by the pool functions instead of rescanning every
+// status list like the original game. Debug builds still rescan them to verify that they are up to date
 void pool_tick();
 
 // Allocate a new object from the given object pool with the initial given status.
-// Returns the index of the new object, or -1 if an object could not be allocated
+// Returns the index of the new object, or -1 if an object could not be allocated.
+// The lowest free index is always allocated, like in the original game
 s32 pool_alloc(PoolInfo *info, u8 status);
 
+// Free the object at `idx` in the given object pool
+void pool_free(PoolInfo *info, u32 idx);
+
+// Set the status of the object at `idx` in the given object pool, where a status of 0 frees it
+void pool_set_status(PoolInfo *info, u32 idx, u8 status);
+
 // Delete all objects from the given pool
 void pool_clear(PoolInfo *info);
 
+// Call `callback(idx)` with the index of each live object (nonzero status) in the given pool, in ascending order.
+// Free slots are skipped 64 at a time using the free bitmap, so walking a sparse pool costs a few instructions per
+// live object rather than a status byte check per slot. The callback may free or change the status of the object it's
+// given, but objects allocated during the walk may or may not be visited
+template <typename F>
+void pool_for_each_live(PoolInfo *info, F callback)
+{
+    for (u32 word = 0; word * 64 < info->live_end; word++)
+    {
+        uint64_t live_bits = ~info->free_bitmap[word] & bitmap_slot_mask(info->len, word);
+        while (live_bits != 0)
+        {
+            callback(word * 64 + bitmap_ctz(live_bits));
+            live_bits &= live_bits - 1;
+        }
+    }
 }
+
+/*
+ * Round `size` up to a multiple of the alignment of everything stored in pool arenas.
+ */
+constexpr u32 pool_arena_align(u32 size)
+{
+    return (size + 63) / 64 * 64;
+}
+
+/*
+ * Metadata of an object pool, without its slots. See `Pool`, `SoaPool`, and `ArenaPool`.
+ *
+ * The members are thin wrappers over the `pool_` functions. Pools are trivially copyable, but a pool whose storage is
+ * in an arena must be copied along with the arena, see `global_state_snapshot()`.
+ */
+struct PoolBase
+{
+    PoolInfo pool_info;
+
+    // Metadata for use with the `pool_` functions. Its pointers are refreshed on every call so that copies of the pool,
+    // like snapshots of GlobalState, remain valid
+    PoolInfo *info()
+    {
+        pool_info.status_list = (u8 *) this + status_list_offset;
+        pool_info.free_bitmap = (uint64_t *) ((u8 *) this + free_bitmap_offset);
+        return &pool_info;
+    }
+
+    // Number of slots in the pool
+    u32 capacity() { return pool_info.len; }
+
+    s32 alloc(u8 status) { return pool_alloc(info(), status); }
+    void free(u32 idx) { pool_free(info(), idx); }
+    void set_status(u32 idx, u8 status) { pool_set_status(info(), idx, status); }
+    void clear() { pool_clear(info()); }
+
+    // Call `callback(idx)` for each live object, see `pool_for_each_live()`
+    template <typename F>
+    void for_each_live_idx(F callback)
+    {
+        pool_for_each_live(info(), callback);
+    }
+
+protected:
+    // Use `capacity` slots stored at `slot_status_list` and `slot_free_bitmap`, which must be part of or after the pool
+    void init_slots(u32 capacity, u8 *slot_status_list, uint64_t *slot_free_bitmap)
+    {
+        pool_info.len = capacity;
+        status_list_offset = (u32) ((u8 *) slot_status_list - (u8 *) this);
+        free_bitmap_offset = (u32) ((u8 *) slot_free_bitmap - (u8 *) this);
+        pool_clear(info());
+    }
+
+    // Byte offsets from the start of the pool to its status list and free bitmap, which are either part of the pool
+    // or in an arena placed after it. Offsets rather than pointers so that copies of the pool and its arena remain
+    // valid
+    u32 status_list_offset;
+    u32 free_bitmap_offset;
+};
+
+/*
+ * Status list and free bitmap of an object pool of `N` slots stored in the pool itself, without the objects
+ * themselves. See `Pool` and `SoaPool`.
+ */
+template <u32 N>
+struct PoolSlots : PoolBase
+{
+    void init() { init_slots(N, status_list, free_bitmap); }
+
+protected:
+    // Only accessible through `info()`, so that statuses are only changed through the pool functions
+    u8 status_list[N];
+    uint64_t free_bitmap[pool_bitmap_len(N)];
+};
+
+/*
+ * Object pool holding `N` objects of type `T` along with their statuses.
+ */
+template <typename T, u32 N>
+struct Pool : PoolSlots<N>
+{
+    T objs[N];
+
+    T *obj_list() { return objs; }
+    T &operator[](u32 idx) { return objs[idx]; }
+
+    // Call `callback(idx, obj)` for each live object, see `pool_for_each_live()`
+    template <typename F>
+    void for_each_live(F callback)
+    {
+        pool_for_each_live(this->info(), [&](u32 idx) { callback(idx, objs[idx]); });
+    }
+};
+
+/*
+ * Object pool whose objects are stored as a struct of arrays: `Fields<N>` is a struct with an `N`-element array per
+ * field of the object, such as
+ *
+ *     template <u32 N>
+ *     struct EffectMotion
+ *     {
+ *         Vec3f pos[N];
+ *         Vec3f vel[N];
+ *     };
+ *
+ * so that hot fields of every object are contiguous and can be updated with vectorized loops over `0..upper_bound`.
+ * Always has exactly `N` slots.
+ */
+template <template <u32> class Fields, u32 N>
+struct SoaPool : PoolSlots<N>
+{
+    Fields<N> fields;
+};
+
+/*
+ * Object pool holding objects of type `T` along with their statuses, whose capacity is chosen when it's initialized.
+ * All of its slots are stored in an arena placed after the pool, such as the one allocated by `global_state_create()`.
+ */
+template <typename T>
+struct ArenaPool : PoolBase
+{
+    T *obj_list() { return (T *) ((u8 *) this + objs_offset); }
+    T &operator[](u32 idx) { return obj_list()[idx]; }
+
+    // Number of arena bytes needed by a pool with `capacity` slots
+    static constexpr u32 arena_size(u32 capacity)
+    {
+        return pool_arena_align(capacity * sizeof(T)) + pool_arena_align(pool_bitmap_len(capacity) * 8) +
+               pool_arena_align(capacity);
+    }
+
+    // Initialize the pool with `capacity` slots taken from `*arena`, which is then advanced past them. The arena
+    // ending at `arena_end` must have room for them
+    void init(u32 capacity, u8 **arena, u8 *arena_end)
+    {
+        assert((u32) (arena_end - *arena) >= arena_size(capacity));
+
+        T *arena_objs = (T *) *arena;
+        uint64_t *arena_free_bitmap = (uint64_t *) (*arena + pool_arena_align(capacity * sizeof(T)));
+        u8 *arena_status_list = (u8 *) arena_free_bitmap + pool_arena_align(pool_bitmap_len(capacity) * 8);
+        *arena += arena_size(capacity);
+
+        init_slots(capacity, arena_status_list, arena_free_bitmap);
+        objs_offset = (u32) ((u8 *) arena_objs - (u8 *) this);
+    }
+
+    // Call `callback(idx, obj)` for each live object, see `pool_for_each_live()`
+    template <typename F>
+    void for_each_live(F callback)
+    {
+        T *objs = obj_list();
+        pool_for_each_live(info(), [&](u32 idx) { callback(idx, objs[idx]); });
+    }
+
+private:
+    // Byte offset from the start of the pool to its objects in the arena
+    u32 objs_offset;
+};
+
+}
\ No newline at end of file
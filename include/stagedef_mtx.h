@@ -0,0 +1,32 @@
+#pragma once
+
+/*
+ * Compute world-space transforms of stagedef objects
+ */
+
+#include "mathtypes.h"
+
+namespace mkb2
+{
+
+// Forward declarations
+struct StagedefCollisionHeader;
+
+/*
+ * Number of matrices `stagedef_coli_header_to_world_mtxs()` writes for `coli_header`.
+ */
+u32 stagedef_coli_header_child_count(StagedefCollisionHeader *coli_header);
+
+/*
+ * Write the world-space transform of every child object of `coli_header` to `out_mtxs`, which must have room for
+ * `stagedef_coli_header_child_count(coli_header)` matrices. Returns the number of matrices written.
+ *
+ * `coli_header_mtx` is the collision header's current (animated) transform, which is concatenated with each child's
+ * own transform. Matrices are written in this order: bumpers, jamabars, bananas, cone collision objects, then stage
+ * model instances. Bananas only have a translation; the other objects use the game's ZYX rotation order.
+ *
+ * Matrix A is not modified.
+ */
+u32 stagedef_coli_header_to_world_mtxs(StagedefCollisionHeader *coli_header, Mtx *coli_header_mtx, Mtx *out_mtxs);
+
+}
\ No newline at end of file
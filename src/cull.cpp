@@ -0,0 +1,252 @@
+#include "cull.h"
+
+#include <Eigen/Core>
+
+#include "mathutil.h"
+#include "stagedef.h"
+
+namespace mkb2
+{
+
+/*
+ * Number of stagedef objects whose world matrices are computed at once by the bounding sphere functions.
+ */
+constexpr u32 SPHERE_CHUNK_LEN = 64;
+
+/*
+ * Append the indices `first_idx + lane` of the lanes set in `visible_lanes` to `out_idxs`, starting at
+ * `visible_count`. Returns the new visible count.
+ *
+ * Every lane's index is written unconditionally and only the visible ones are kept by advancing the count, so there
+ * are no unpredictable branches. `out_idxs` must have room for an index past the last visible one.
+ */
+inline u32 push_visible_lanes(u32 visible_lanes, u32 lane_count, u32 first_idx, u32 *out_idxs, u32 visible_count)
+{
+    for (u32 lane = 0; lane < lane_count; lane++)
+    {
+        out_idxs[visible_count] = first_idx + lane;
+        visible_count += (visible_lanes >> lane) & 1;
+    }
+    return visible_count;
+}
+
+/*
+ * Signed distance from `plane` to (x, y, z). The SIMD paths perform the same operations in the same order, so they
+ * cull exactly the same volumes.
+ */
+inline f32 plane_dist(const Plane &plane, f32 x, f32 y, f32 z)
+{
+    return plane.normal.x * x + plane.normal.y * y + plane.normal.z * z + plane.dist;
+}
+
+inline bool sphere_visible(const Frustum &frustum, const Sphere &sphere)
+{
+    bool visible = true;
+    for (const Plane &plane : frustum.planes)
+    {
+        f32 dist = plane_dist(plane, sphere.center.x, sphere.center.y, sphere.center.z);
+        visible &= !(dist < -sphere.radius);
+    }
+    return visible;
+}
+
+/*
+ * Tests the corner of `aabb` furthest along each plane's normal, which is inside the plane if any part of the box is.
+ */
+inline bool aabb_visible(const Frustum &frustum, const Aabb &aabb)
+{
+    bool visible = true;
+    for (const Plane &plane : frustum.planes)
+    {
+        f32 x = plane.normal.x >= 0.f ? aabb.max.x : aabb.min.x;
+        f32 y = plane.normal.y >= 0.f ? aabb.max.y : aabb.min.y;
+        f32 z = plane.normal.z >= 0.f ? aabb.max.z : aabb.min.z;
+        visible &= !(plane_dist(plane, x, y, z) < 0.f);
+    }
+    return visible;
+}
+
+#ifdef EIGEN_VECTORIZE_SSE
+
+inline __m128 plane_dist_lanes(const Plane &plane, __m128 x, __m128 y, __m128 z)
+{
+    __m128 dist = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.normal.x), x), _mm_mul_ps(_mm_set1_ps(plane.normal.y), y));
+    dist = _mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(plane.normal.z), z));
+    return _mm_add_ps(dist, _mm_set1_ps(plane.dist));
+}
+
+#endif
+
+void frustum_from_mtx44(Frustum *out_frustum, Mtx44 *view_proj)
+{
+    // Each plane is a combination of the rows of the matrix (Gribb & Hartmann). The view volume in clip space is
+    // -w <= x, y <= w and -w <= z <= 0.
+    static constexpr f32 ROW_FACTORS[6][4] = {
+        {1.f, 0.f, 0.f, 1.f},  // Left: x >= -w
+        {-1.f, 0.f, 0.f, 1.f}, // Right: x <= w
+        {0.f, 1.f, 0.f, 1.f},  // Bottom: y >= -w
+        {0.f, -1.f, 0.f, 1.f}, // Top: y <= w
+        {0.f, 0.f, 1.f, 1.f},  // Near: z >= -w
+        {0.f, 0.f, -1.f, 0.f}, // Far: z <= 0
+    };
+
+    for (s32 i = 0; i < 6; i++)
+    {
+        f32 coefs[4];
+        for (s32 col = 0; col < 4; col++)
+        {
+            coefs[col] = 0.f;
+            for (s32 row = 0; row < 4; row++) coefs[col] += ROW_FACTORS[i][row] * (*view_proj)[row][col];
+        }
+
+        f32 inv_len = 1.f / math_sqrt(coefs[0] * coefs[0] + coefs[1] * coefs[1] + coefs[2] * coefs[2]);
+        Plane &plane = out_frustum->planes[i];
+        plane.normal = {coefs[0] * inv_len, coefs[1] * inv_len, coefs[2] * inv_len};
+        plane.dist = coefs[3] * inv_len;
+    }
+}
+
+void frustum_from_camera(Frustum *out_frustum, Mtx44 *proj, Mtx *view)
+{
+    Mtx44 view_proj;
+    mtx44_mult_mtx(proj, view, &view_proj);
+    frustum_from_mtx44(out_frustum, &view_proj);
+}
+
+u32 cull_spheres(Frustum *frustum, Sphere *spheres, u32 count, u32 *out_visible_idxs)
+{
+    u32 visible_count = 0;
+    u32 i = 0;
+
+#ifdef EIGEN_VECTORIZE_SSE
+    static_assert(sizeof(Sphere) == 4 * sizeof(f32), "Sphere must be tightly packed");
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(&spheres[i].center.x);
+        __m128 y = _mm_loadu_ps(&spheres[i + 1].center.x);
+        __m128 z = _mm_loadu_ps(&spheres[i + 2].center.x);
+        __m128 radius = _mm_loadu_ps(&spheres[i + 3].center.x);
+        _MM_TRANSPOSE4_PS(x, y, z, radius);
+        __m128 neg_radius = _mm_xor_ps(radius, _mm_set1_ps(-0.f));
+
+        __m128 outside = _mm_setzero_ps();
+        for (const Plane &plane : frustum->planes)
+        {
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(plane_dist_lanes(plane, x, y, z), neg_radius));
+        }
+        u32 visible_lanes = ~_mm_movemask_ps(outside);
+        visible_count = push_visible_lanes(visible_lanes, 4, i, out_visible_idxs, visible_count);
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        visible_count = push_visible_lanes(sphere_visible(*frustum, spheres[i]), 1, i, out_visible_idxs, visible_count);
+    }
+    return visible_count;
+}
+
+u32 cull_aabbs(Frustum *frustum, Aabb *aabbs, u32 count, u32 *out_visible_idxs)
+{
+    u32 visible_count = 0;
+    u32 i = 0;
+
+#ifdef EIGEN_VECTORIZE_SSE
+    static_assert(sizeof(Aabb) == 6 * sizeof(f32), "Aabb must be tightly packed");
+    for (; i + 4 <= count; i += 4)
+    {
+        // Two overlapping loads per box stay within it: (min.x, min.y, min.z, max.x) and (min.z, max.x, max.y, max.z)
+        __m128 min_x = _mm_loadu_ps(&aabbs[i].min.x);
+        __m128 min_y = _mm_loadu_ps(&aabbs[i + 1].min.x);
+        __m128 min_z = _mm_loadu_ps(&aabbs[i + 2].min.x);
+        __m128 max_x = _mm_loadu_ps(&aabbs[i + 3].min.x);
+        _MM_TRANSPOSE4_PS(min_x, min_y, min_z, max_x);
+        __m128 unused_min_z = _mm_loadu_ps(&aabbs[i].min.z);
+        __m128 unused_max_x = _mm_loadu_ps(&aabbs[i + 1].min.z);
+        __m128 max_y = _mm_loadu_ps(&aabbs[i + 2].min.z);
+        __m128 max_z = _mm_loadu_ps(&aabbs[i + 3].min.z);
+        _MM_TRANSPOSE4_PS(unused_min_z, unused_max_x, max_y, max_z);
+
+        __m128 outside = _mm_setzero_ps();
+        for (const Plane &plane : frustum->planes)
+        {
+            __m128 x = plane.normal.x >= 0.f ? max_x : min_x;
+            __m128 y = plane.normal.y >= 0.f ? max_y : min_y;
+            __m128 z = plane.normal.z >= 0.f ? max_z : min_z;
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(plane_dist_lanes(plane, x, y, z), _mm_setzero_ps()));
+        }
+        u32 visible_lanes = ~_mm_movemask_ps(outside);
+        visible_count = push_visible_lanes(visible_lanes, 4, i, out_visible_idxs, visible_count);
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        visible_count = push_visible_lanes(aabb_visible(*frustum, aabbs[i]), 1, i, out_visible_idxs, visible_count);
+    }
+    return visible_count;
+}
+
+/*
+ * Bounding sphere of `model_bounds` transformed by `mtx`.
+ *
+ * The radius is scaled by the length of the matrix's longest basis vector, so it stays conservative under
+ * non-uniform scales.
+ */
+inline Sphere sphere_tf(Mtx &mtx, const Sphere &model_bounds)
+{
+    const Vec3f &center = model_bounds.center;
+    Sphere sphere;
+    sphere.center.x = mtx[0][0] * center.x + mtx[0][1] * center.y + mtx[0][2] * center.z + mtx[0][3];
+    sphere.center.y = mtx[1][0] * center.x + mtx[1][1] * center.y + mtx[1][2] * center.z + mtx[1][3];
+    sphere.center.z = mtx[2][0] * center.x + mtx[2][1] * center.y + mtx[2][2] * center.z + mtx[2][3];
+
+    f32 max_len_sq = 0.f;
+    for (s32 col = 0; col < 3; col++)
+    {
+        f32 len_sq = mtx[0][col] * mtx[0][col] + mtx[1][col] * mtx[1][col] + mtx[2][col] * mtx[2][col];
+        if (len_sq > max_len_sq) max_len_sq = len_sq;
+    }
+    sphere.radius = model_bounds.radius * math_sqrt(max_len_sq);
+    return sphere;
+}
+
+/*
+ * Compute bounding spheres of `count` stagedef objects with a position, rotation, and scale, a chunk at a time.
+ */
+template <typename T>
+inline void stagedef_obj_spheres(T *objs, u32 count, Mtx *parent_mtx, Sphere *model_bounds, Sphere *out_spheres)
+{
+    Mtx mtxs[SPHERE_CHUNK_LEN];
+    for (u32 start = 0; start < count; start += SPHERE_CHUNK_LEN)
+    {
+        u32 chunk_len = count - start < SPHERE_CHUNK_LEN ? count - start : SPHERE_CHUNK_LEN;
+        mtx_from_trs_batch(objs + start, mtxs, chunk_len, EULER_ORDER_ZYX);
+        if (parent_mtx != nullptr) mtx_mult_batch(parent_mtx, mtxs, mtxs, chunk_len);
+        for (u32 i = 0; i < chunk_len; i++) out_spheres[start + i] = sphere_tf(mtxs[i], model_bounds[start + i]);
+    }
+}
+
+void stagedef_banana_spheres(StagedefBanana *bananas, u32 count, Mtx *coli_header_mtx, Sphere *out_spheres)
+{
+    Mtx identity = {{1.f, 0.f, 0.f, 0.f}, {0.f, 1.f, 0.f, 0.f}, {0.f, 0.f, 1.f, 0.f}};
+    Mtx &mtx = coli_header_mtx != nullptr ? *coli_header_mtx : identity;
+    for (u32 i = 0; i < count; i++)
+    {
+        out_spheres[i] = sphere_tf(mtx, {bananas[i].position, BANANA_CULL_RADIUS});
+    }
+}
+
+void stagedef_stage_model_instance_spheres(StagedefStageModelInstance *instances, u32 count, Mtx *coli_header_mtx,
+                                           Sphere *model_bounds, Sphere *out_spheres)
+{
+    stagedef_obj_spheres(instances, count, coli_header_mtx, model_bounds, out_spheres);
+}
+
+void stagedef_background_model_spheres(StagedefBackgroundModel *models, u32 count, Sphere *model_bounds,
+                                       Sphere *out_spheres)
+{
+    stagedef_obj_spheres(models, count, nullptr, model_bounds, out_spheres);
+}
+
+}
\ No newline at end of file
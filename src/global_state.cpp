@@ -1,8 +1,60 @@
 #include "global_state.h"
 
+#include <cstring>
+
 namespace mkb2
 {
 
-std::unique_ptr<GlobalState> gs(std::make_unique<GlobalState>());
+std::unique_ptr<GlobalState> gs(global_state_create(VANILLA_POOL_CAPACITIES));
+
+void *GlobalState::operator new(size_t size, u32 arena_size)
+{
+    void *ptr = ::operator new(size + arena_size);
+    memset((u8 *) ptr + size, 0, arena_size);
+    return ptr;
+}
+
+void GlobalState::operator delete(void *ptr)
+{
+    ::operator delete(ptr);
+}
+
+std::unique_ptr<GlobalState> global_state_create(PoolCapacities pool_capacities)
+{
+    u32 arena_size = pool_arena_size(&pool_capacities);
+    std::unique_ptr<GlobalState> state(new (arena_size) GlobalState());
+    state->pool_capacities = pool_capacities;
+    state->pool_arena_size = arena_size;
+    return state;
+}
+
+/*
+ * Copy `src` and its pool arena over `dst`, which must have an arena of the same size.
+ */
+static void global_state_copy(GlobalState *dst, GlobalState *src)
+{
+    memcpy(dst, src, sizeof(GlobalState) + src->get_pool_arena_size());
+
+    // Pools locate their storage with offsets and are fine as copied, but these point into the GlobalState itself
+    if (src->mtxa == &src->mtxa_raw) dst->mtxa = &dst->mtxa_raw;
+    dst->mtx_stack_ptr = dst->mtx_stack + (src->mtx_stack_ptr - src->mtx_stack);
+}
+
+std::unique_ptr<GlobalState> global_state_snapshot(GlobalState *state)
+{
+    std::unique_ptr<GlobalState> snapshot(new (state->get_pool_arena_size()) GlobalState());
+    global_state_copy(snapshot.get(), state);
+    return snapshot;
+}
+
+bool global_state_restore(GlobalState *state, GlobalState *snapshot)
+{
+    PoolCapacities capacities = state->get_pool_capacities();
+    PoolCapacities snapshot_capacities = snapshot->get_pool_capacities();
+    if (memcmp(&capacities, &snapshot_capacities, sizeof(PoolCapacities)) != 0) return false;
+
+    global_state_copy(state, snapshot);
+    return true;
+}
 
 }
\ No newline at end of file
@@ -9,14 +9,17 @@
  */
 
 // TODO check more NAN/INF cases?
-// TODO implement trig functions using SMB's trig tables for improved accuracy?
 
 #include "mathutil.h"
+#include "mathpolicy.h"
 
 // Needed for M_PI and other constants from <cmath>
 #define _USE_MATH_DEFINES
 
 #include <Eigen/Dense>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
 
 #include "mathtypes.h"
 #include "vecutil.h"
@@ -26,52 +29,124 @@ namespace mkb2
 {
 
 /*
- * Eigen transform matrix type used to wrap the game's Mtx type.
+ * Eigen transform matrix type, used where we need Eigen's Transform functionality (like inverting or extracting
+ * a rotation).
  */
 using EigenMtx = Eigen::Transform<f32, 3, Eigen::AffineCompact, Eigen::RowMajor>;
 
 /*
- * Various helpers to convert between Eigen and the game's math types.
+ * Eigen views over the game's Mtx type.
  *
- * Conversion performed by copying which is slow; if you find a better way, let me know.
+ * These alias the original matrix memory directly instead of copying it into a temporary. A Mtx is only guaranteed
+ * to be 4-byte aligned, so the maps are unaligned. The 3x3 "square" part of the matrix is `leftCols<3>()` and the
+ * translation is `col(3)`.
  */
+using EigenMtxMap = Eigen::Map<Eigen::Matrix<f32, 3, 4, Eigen::RowMajor>>;
 
-inline EigenMtx emtx_from_mtxa()
+inline EigenMtxMap emap_mtxa()
 {
-    EigenMtx emtx;
-    memcpy(emtx.data(), gs->mtxa_raw, sizeof(Mtx));
-    return emtx;
+    return EigenMtxMap(&gs->mtxa_raw[0][0]);
 }
 
-inline void emtx_to_mtxa(const EigenMtx &emtx)
+inline EigenMtxMap emap_mtxb()
 {
-    memcpy(gs->mtxa_raw, emtx.data(), sizeof(Mtx));
+    return EigenMtxMap(&gs->mtxb_raw[0][0]);
 }
 
-inline EigenMtx emtx_from_mtxb()
+inline EigenMtxMap emap_mtx(Mtx *mtx)
 {
-    EigenMtx emtx;
-    memcpy(emtx.data(), gs->mtxb_raw, sizeof(Mtx));
-    return emtx;
+    return EigenMtxMap(&(*mtx)[0][0]);
 }
 
-inline void emtx_to_mtxb(const EigenMtx &emtx)
+/*
+ * Assign `dst` to the affine matrix product of `left` and `right`.
+ *
+ * Each row of the result is a combination of the rows of `right`, so it's computed a whole row at a time, which maps
+ * directly onto 4-wide SIMD. `dst` may alias `left` and/or `right`. With `ALIGNED`, all three matrices must be 16-byte
+ * aligned.
+ */
+template <bool ALIGNED = false>
+inline void mtx_mult_rows(Mtx &dst, Mtx &left, Mtx &right)
+{
+#ifdef EIGEN_VECTORIZE_SSE
+    auto load = [](f32 *row) { return ALIGNED ? _mm_load_ps(row) : _mm_loadu_ps(row); };
+    __m128 right0 = load(right[0]);
+    __m128 right1 = load(right[1]);
+    __m128 right2 = load(right[2]);
+
+    __m128 results[3];
+    for (s32 row = 0; row < 3; row++)
+    {
+        // Adding -0 leaves the first three columns exactly as they are, including signed zeros
+        __m128 translate = _mm_set_ps(left[row][3], -0.f, -0.f, -0.f);
+        __m128 sum = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(left[row][0]), right0),
+                                _mm_mul_ps(_mm_set1_ps(left[row][1]), right1));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(left[row][2]), right2));
+        results[row] = _mm_add_ps(sum, translate);
+    }
+    for (s32 row = 0; row < 3; row++)
+    {
+        if (ALIGNED) _mm_store_ps(dst[row], results[row]);
+        else _mm_storeu_ps(dst[row], results[row]);
+    }
+#else
+    Mtx result;
+    for (s32 row = 0; row < 3; row++)
+    {
+        for (s32 col = 0; col < 4; col++)
+        {
+            result[row][col] = left[row][0] * right[0][col] + left[row][1] * right[1][col] +
+                               left[row][2] * right[2][col];
+        }
+        result[row][3] += left[row][3];
+    }
+    memcpy(dst, result, sizeof(Mtx));
+#endif
+}
+
+/*
+ * Copy 16-byte aligned `src` to 16-byte aligned `dst`.
+ */
+inline void mtx_copy_aligned(Mtx &src, Mtx &dst)
 {
-    memcpy(gs->mtxb_raw, emtx.data(), sizeof(Mtx));
+#ifdef EIGEN_VECTORIZE_SSE
+    for (s32 row = 0; row < 3; row++) _mm_store_ps(dst[row], _mm_load_ps(src[row]));
+#else
+    memcpy(dst, src, sizeof(Mtx));
+#endif
 }
 
-inline EigenMtx emtx_from_mtx(Mtx *mtx)
+#ifdef EIGEN_VECTORIZE_SSE
+
+/*
+ * Load the rows of 16-byte aligned `mtx`, transposed into its four columns. The last lane of each column is zero.
+ */
+inline void mtx_cols_load(Mtx &mtx, __m128 (&cols)[4])
 {
-    EigenMtx emtx;
-    memcpy(emtx.data(), mtx, sizeof(Mtx));
-    return emtx;
+    cols[0] = _mm_load_ps(mtx[0]);
+    cols[1] = _mm_load_ps(mtx[1]);
+    cols[2] = _mm_load_ps(mtx[2]);
+    cols[3] = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(cols[0], cols[1], cols[2], cols[3]);
 }
 
-inline void emtx_to_mtx(const EigenMtx &emtx, Mtx *mtx)
+/*
+ * Compute basis[0] * vec.x + basis[1] * vec.y + basis[2] * vec.z.
+ *
+ * With `basis` being a matrix's columns this transforms `vec` by the matrix a whole vector at a time, performing the
+ * same operations in the same order as the per-component kernels.
+ */
+inline __m128 vec_lanes_combine(const __m128 *basis, __m128 vec)
 {
-    memcpy(mtx, emtx.data(), sizeof(Mtx));
+    __m128 x = _mm_shuffle_ps(vec, vec, _MM_SHUFFLE(0, 0, 0, 0));
+    __m128 y = _mm_shuffle_ps(vec, vec, _MM_SHUFFLE(1, 1, 1, 1));
+    __m128 z = _mm_shuffle_ps(vec, vec, _MM_SHUFFLE(2, 2, 2, 2));
+    __m128 sum = _mm_add_ps(_mm_mul_ps(basis[0], x), _mm_mul_ps(basis[1], y));
+    return _mm_add_ps(sum, _mm_mul_ps(basis[2], z));
 }
 
+#endif
+
 inline Eigen::Vector3f evec_from_vec3f(Vec3f *vec)
 {
     return Eigen::Vector3f((f32 *) vec);
@@ -84,11 +159,6 @@ inline void evec_to_vec3f(const Eigen::Vector3f &evec, Vec3f *vec)
     vec->z = evec.z();
 }
 
-inline Eigen::Quaternionf equat_from_quat(Quat *quat)
-{
-    return Eigen::Quaternionf((f32 *) quat);
-}
-
 inline void equat_to_quat(const Eigen::Quaternionf &equat, Quat *quat)
 {
     quat->x = equat.x();
@@ -97,6 +167,783 @@ inline void equat_to_quat(const Eigen::Quaternionf &equat, Quat *quat)
     quat->w = equat.w();
 }
 
+/*
+ * Lane arrays used by batched functions to process several vectors at once with SIMD.
+ *
+ * Eigen picks the instruction set (SSE, AVX, NEON...) based on the compiler flags and falls back to scalar code
+ * when none is available. Four lanes are used even with AVX; converting between arrays of Vec3f and lanes
+ * dominates the cost of these functions, and is cheapest done four vectors at a time.
+ *
+ * Batched functions share their arithmetic with the single-vector functions through kernels: function objects with
+ * a call operator templated on f32 / LaneArray. Both paths perform the exact same floating-point operations in the
+ * same order and produce identical results.
+ */
+constexpr u32 LANE_COUNT = 4;
+
+using LaneArray = Eigen::Array<f32, LANE_COUNT, 1>;
+
+/*
+ * View of one component of LANE_COUNT consecutive Vec3f's.
+ */
+using Vec3fLaneMap = Eigen::Map<LaneArray, Eigen::Unaligned, Eigen::InnerStride<3>>;
+
+static_assert(sizeof(Vec3f) == 3 * sizeof(f32), "Vec3f must be tightly packed for Vec3fLaneMap");
+
+/*
+ * Load LANE_COUNT consecutive Vec3f's into separate x, y, and z lane arrays.
+ *
+ * With SSE, the four Vec3f's are loaded as three full registers and shuffled into place, which is much faster than
+ * Eigen's generic strided gather.
+ */
+inline void vec3f_lanes_load(Vec3f *src, LaneArray &x, LaneArray &y, LaneArray &z)
+{
+#ifdef EIGEN_VECTORIZE_SSE
+    // a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3
+    __m128 a = _mm_loadu_ps(&src[0].x);
+    __m128 b = _mm_loadu_ps(&src[1].y);
+    __m128 c = _mm_loadu_ps(&src[2].z);
+    __m128 x2y2x3y3 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 1, 3, 2));
+    __m128 y0z0y1z1 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 2, 1));
+    _mm_store_ps(x.data(), _mm_shuffle_ps(a, x2y2x3y3, _MM_SHUFFLE(2, 0, 3, 0)));
+    _mm_store_ps(y.data(), _mm_shuffle_ps(y0z0y1z1, x2y2x3y3, _MM_SHUFFLE(3, 1, 2, 0)));
+    _mm_store_ps(z.data(), _mm_shuffle_ps(y0z0y1z1, c, _MM_SHUFFLE(3, 0, 3, 1)));
+#else
+    x = Vec3fLaneMap(&src->x);
+    y = Vec3fLaneMap(&src->y);
+    z = Vec3fLaneMap(&src->z);
+#endif
+}
+
+/*
+ * Store separate x, y, and z lane arrays to LANE_COUNT consecutive Vec3f's.
+ */
+inline void vec3f_lanes_store(const LaneArray &x, const LaneArray &y, const LaneArray &z, Vec3f *dst)
+{
+#ifdef EIGEN_VECTORIZE_SSE
+    __m128 xv = _mm_load_ps(x.data());
+    __m128 yv = _mm_load_ps(y.data());
+    __m128 zv = _mm_load_ps(z.data());
+    __m128 x0y0x1y1 = _mm_unpacklo_ps(xv, yv);
+    __m128 z0z0x1x1 = _mm_shuffle_ps(zv, xv, _MM_SHUFFLE(1, 1, 0, 0));
+    __m128 y1y1z1z1 = _mm_shuffle_ps(yv, zv, _MM_SHUFFLE(1, 1, 1, 1));
+    __m128 x2x2y2y2 = _mm_shuffle_ps(xv, yv, _MM_SHUFFLE(2, 2, 2, 2));
+    __m128 z2z2x3x3 = _mm_shuffle_ps(zv, xv, _MM_SHUFFLE(3, 3, 2, 2));
+    __m128 y3y3z3z3 = _mm_shuffle_ps(yv, zv, _MM_SHUFFLE(3, 3, 3, 3));
+    _mm_storeu_ps(&dst[0].x, _mm_shuffle_ps(x0y0x1y1, z0z0x1x1, _MM_SHUFFLE(2, 0, 1, 0)));
+    _mm_storeu_ps(&dst[1].y, _mm_shuffle_ps(y1y1z1z1, x2x2y2y2, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(&dst[2].z, _mm_shuffle_ps(z2z2x3x3, y3y3z3z3, _MM_SHUFFLE(2, 0, 2, 0)));
+#else
+    Vec3fLaneMap(&dst->x) = x;
+    Vec3fLaneMap(&dst->y) = y;
+    Vec3fLaneMap(&dst->z) = z;
+#endif
+}
+
+/*
+ * Transform (x, y, z) by `mtx` as a point (including translation).
+ */
+struct TfPointKernel
+{
+    template <typename T>
+    void operator()(const Mtx &mtx, const T &x, const T &y, const T &z, T &out_x, T &out_y, T &out_z) const
+    {
+        out_x = mtx[0][0] * x + mtx[0][1] * y + mtx[0][2] * z + mtx[0][3];
+        out_y = mtx[1][0] * x + mtx[1][1] * y + mtx[1][2] * z + mtx[1][3];
+        out_z = mtx[2][0] * x + mtx[2][1] * y + mtx[2][2] * z + mtx[2][3];
+    }
+};
+
+/*
+ * Transform (x, y, z) by `mtx` as a vector (excluding translation).
+ */
+struct TfVecKernel
+{
+    template <typename T>
+    void operator()(const Mtx &mtx, const T &x, const T &y, const T &z, T &out_x, T &out_y, T &out_z) const
+    {
+        out_x = mtx[0][0] * x + mtx[0][1] * y + mtx[0][2] * z;
+        out_y = mtx[1][0] * x + mtx[1][1] * y + mtx[1][2] * z;
+        out_z = mtx[2][0] * x + mtx[2][1] * y + mtx[2][2] * z;
+    }
+};
+
+/*
+ * Transform (x, y, z) by the inverse of `mtx` as a vector, assuming `mtx` is a rigid transformation.
+ *
+ * The inverse of a rotation is its transpose, so this transforms by the transposed square part of `mtx`.
+ */
+struct RigidInvTfVecKernel
+{
+    template <typename T>
+    void operator()(const Mtx &mtx, const T &x, const T &y, const T &z, T &out_x, T &out_y, T &out_z) const
+    {
+        out_x = mtx[0][0] * x + mtx[1][0] * y + mtx[2][0] * z;
+        out_y = mtx[0][1] * x + mtx[1][1] * y + mtx[2][1] * z;
+        out_z = mtx[0][2] * x + mtx[1][2] * y + mtx[2][2] * z;
+    }
+};
+
+/*
+ * Transform (x, y, z) by the inverse of `mtx` as a point, assuming `mtx` is a rigid transformation.
+ */
+struct RigidInvTfPointKernel
+{
+    template <typename T>
+    void operator()(const Mtx &mtx, const T &x, const T &y, const T &z, T &out_x, T &out_y, T &out_z) const
+    {
+        T rel_x = x - mtx[0][3];
+        T rel_y = y - mtx[1][3];
+        T rel_z = z - mtx[2][3];
+        RigidInvTfVecKernel()(mtx, rel_x, rel_y, rel_z, out_x, out_y, out_z);
+    }
+};
+
+/*
+ * Apply `kernel` with matrix `mtx` to `count` Vec3f's from `src`, writing the results to `dst`.
+ *
+ * Full groups of LANE_COUNT vectors are processed with lane arrays and the remainder one at a time.
+ * `src` and `dst` may be the same array.
+ */
+template <typename Kernel>
+inline void tf_batch(const Mtx &mtx, Vec3f *src, Vec3f *dst, u32 count, Kernel kernel)
+{
+    u32 i = 0;
+    for (; i + LANE_COUNT <= count; i += LANE_COUNT)
+    {
+        LaneArray x, y, z, out_x, out_y, out_z;
+        vec3f_lanes_load(&src[i], x, y, z);
+        kernel(mtx, x, y, z, out_x, out_y, out_z);
+        vec3f_lanes_store(out_x, out_y, out_z, &dst[i]);
+    }
+
+    for (; i < count; i++)
+    {
+        f32 out_x, out_y, out_z;
+        kernel(mtx, src[i].x, src[i].y, src[i].z, out_x, out_y, out_z);
+        dst[i] = {out_x, out_y, out_z};
+    }
+}
+
+/*
+ * Elementwise helpers so kernels can be written once for both f32 and LaneArray.
+ *
+ * Transcendental functions are applied to each lane with the same libm function the scalar path uses, so results
+ * stay identical between the two.
+ */
+
+template <typename T>
+inline T lane_splat(f32 value);
+
+template <>
+inline f32 lane_splat<f32>(f32 value)
+{
+    return value;
+}
+
+template <>
+inline LaneArray lane_splat<LaneArray>(f32 value)
+{
+    return LaneArray::Constant(value);
+}
+
+inline f32 lane_select(bool cond, f32 a, f32 b)
+{
+    return cond ? a : b;
+}
+
+#ifdef EIGEN_VECTORIZE_SSE
+
+/*
+ * Evaluate a lane condition to a mask with all bits set in the lanes where it holds.
+ *
+ * Eigen evaluates comparisons and `select()` one lane at a time with a branch per lane, so comparisons between f32
+ * lanes are done with SSE directly instead.
+ */
+template <typename Cond>
+inline __m128 lane_mask(const Cond &cond)
+{
+    Eigen::Array<bool, LANE_COUNT, 1> lanes = cond;
+    return _mm_castsi128_ps(_mm_setr_epi32(-lanes[0], -lanes[1], -lanes[2], -lanes[3]));
+}
+
+template <typename Lhs, typename Rhs, Eigen::internal::ComparisonName CMP>
+inline __m128 lane_mask(const Eigen::CwiseBinaryOp<Eigen::internal::scalar_cmp_op<f32, f32, CMP>, Lhs, Rhs> &cond)
+{
+    LaneArray lhs_lanes = cond.lhs();
+    LaneArray rhs_lanes = cond.rhs();
+    __m128 lhs = _mm_load_ps(lhs_lanes.data());
+    __m128 rhs = _mm_load_ps(rhs_lanes.data());
+    if constexpr (CMP == Eigen::internal::cmp_EQ) return _mm_cmpeq_ps(lhs, rhs);
+    else if constexpr (CMP == Eigen::internal::cmp_LT) return _mm_cmplt_ps(lhs, rhs);
+    else if constexpr (CMP == Eigen::internal::cmp_LE) return _mm_cmple_ps(lhs, rhs);
+    else if constexpr (CMP == Eigen::internal::cmp_NEQ) return _mm_cmpneq_ps(lhs, rhs);
+    else if constexpr (CMP == Eigen::internal::cmp_GT) return _mm_cmpgt_ps(lhs, rhs);
+    else if constexpr (CMP == Eigen::internal::cmp_GE) return _mm_cmpge_ps(lhs, rhs);
+    else return _mm_cmpunord_ps(lhs, rhs);
+}
+
+#endif
+
+template <typename Cond>
+inline LaneArray lane_select(const Cond &cond, const LaneArray &a, const LaneArray &b)
+{
+#ifdef EIGEN_VECTORIZE_SSE
+    __m128 mask = lane_mask(cond);
+    LaneArray out;
+    __m128 a_masked = _mm_and_ps(mask, _mm_load_ps(a.data()));
+    __m128 b_masked = _mm_andnot_ps(mask, _mm_load_ps(b.data()));
+    _mm_store_ps(out.data(), _mm_or_ps(a_masked, b_masked));
+    return out;
+#else
+    return cond.select(a, b);
+#endif
+}
+
+inline f32 lane_abs(f32 x)
+{
+    return fabsf(x);
+}
+
+inline LaneArray lane_abs(const LaneArray &x)
+{
+    return x.abs();
+}
+
+inline f32 lane_sqrt(f32 x)
+{
+    return sqrtf(x);
+}
+
+inline LaneArray lane_sqrt(const LaneArray &x)
+{
+    // Not `x.sqrt()`: with EIGEN_FAST_MATH (the default), Eigen approximates vectorized f32 square roots
+    return x.unaryExpr([](f32 lane) { return sqrtf(lane); });
+}
+
+inline f32 lane_acos(f32 x)
+{
+    return acosf(x);
+}
+
+inline LaneArray lane_acos(const LaneArray &x)
+{
+    return x.unaryExpr([](f32 lane) { return acosf(lane); });
+}
+
+inline f32 lane_sin(f32 x)
+{
+    return sinf(x);
+}
+
+inline LaneArray lane_sin(const LaneArray &x)
+{
+    return x.unaryExpr([](f32 lane) { return sinf(lane); });
+}
+
+/*
+ * Emulation of the Gekko CPU's `frsqrte` (floating reciprocal square root estimate) instruction.
+ *
+ * The estimate is read from a 32-entry table of base values and slopes indexed by the exponent's parity and the top
+ * bits of the mantissa, and is accurate to about 1/4096.
+ */
+static f64 gekko_frsqrte(f64 x)
+{
+    struct BaseAndDec
+    {
+        s32 base;
+        s32 dec;
+    };
+    static constexpr BaseAndDec FRSQRTE_TABLE[32] = {
+        // Even exponents
+        {0x1a7e800, 0x568}, {0x17cb800, 0x4f3}, {0x1552800, 0x48d}, {0x130c000, 0x435},
+        {0x10f2000, 0x3e7}, {0x0eff000, 0x3a2}, {0x0d2e000, 0x365}, {0x0b7c000, 0x32e},
+        {0x09e5000, 0x2fe}, {0x0867000, 0x2d2}, {0x06ff000, 0x2aa}, {0x05ab800, 0x286},
+        {0x046a000, 0x265}, {0x0339800, 0x247}, {0x0218800, 0x22b}, {0x0105800, 0x211},
+        // Odd exponents
+        {0x3ffa000, 0x7a4}, {0x3c29000, 0x700}, {0x38aa000, 0x670}, {0x3572000, 0x5f2},
+        {0x3279000, 0x584}, {0x2fb7000, 0x524}, {0x2d26000, 0x4cc}, {0x2ac0000, 0x47e},
+        {0x2881000, 0x43a}, {0x2665000, 0x3fa}, {0x2468000, 0x3c2}, {0x2287000, 0x38e},
+        {0x20c1000, 0x35e}, {0x1f12000, 0x332}, {0x1d79000, 0x30a}, {0x1bf4000, 0x2e6},
+    };
+    constexpr u64 MANTISSA_MASK = (1ull << 52) - 1;
+    constexpr u64 EXPONENT_MASK = 0x7ffull << 52;
+
+    u64 bits;
+    memcpy(&bits, &x, sizeof(bits));
+    u64 sign = bits & (1ull << 63);
+    s64 exponent = bits & EXPONENT_MASK;
+    u64 mantissa = bits & MANTISSA_MASK;
+
+    if (exponent == 0 && mantissa == 0) return sign ? -INFINITY : INFINITY;
+    if (exponent == (s64) EXPONENT_MASK)
+    {
+        if (mantissa != 0) return x;
+        return sign ? NAN : 0.0;
+    }
+    if (sign) return NAN;
+
+    // Normalize denormals
+    if (exponent == 0)
+    {
+        do
+        {
+            exponent -= 1ll << 52;
+            mantissa <<= 1;
+        } while (!(mantissa & (1ull << 52)));
+        mantissa &= MANTISSA_MASK;
+        exponent += 1ll << 52;
+    }
+
+    u64 exponent_lsb = exponent & (1ll << 52);
+    exponent = ((0x3ffll << 52) - ((exponent - (0x3fell << 52)) / 2)) & EXPONENT_MASK;
+
+    s32 idx = (s32) ((exponent_lsb | mantissa) >> 37);
+    const BaseAndDec &entry = FRSQRTE_TABLE[idx / 2048];
+    s32 estimate = entry.base - entry.dec * (idx % 2048);
+
+    // The last even-exponent segment's slope takes it below zero for inputs within about 1.1% below a power of 4.
+    // Dolphin ORs the negative value into the result as-is, which sets the sign and exponent bits and makes the
+    // estimate a negative NaN. Clamp instead: that gives exactly the next power of 2, which is still well within the
+    // table's accuracy there
+    if (estimate < 0) estimate = 0;
+
+    u64 result_bits = exponent | ((u64) estimate << 26);
+
+    f64 result;
+    memcpy(&result, &result_bits, sizeof(result));
+    return result;
+}
+
+/*
+ * Reciprocal square root of a positive value the way the original game computes it: a `frsqrte` estimate refined by
+ * three Newton-Raphson steps in double precision.
+ */
+inline f64 gekko_rsqrt(f64 x)
+{
+    // The refinement would turn the estimate of 0 into NaN (INFINITY * 0)
+    if (x == INFINITY) return 0.0;
+
+    f64 guess = gekko_frsqrte(x);
+    for (s32 i = 0; i < 3; i++) guess = 0.5 * guess * (3.0 - x * (guess * guess));
+    return guess;
+}
+
+/*
+ * Square root of a positive value from its `gekko_rsqrt()`, like the original game, except that INFINITY stays
+ * INFINITY instead of becoming NaN.
+ */
+inline f64 gekko_sqrt(f64 x, f64 rsqrt)
+{
+    return x == INFINITY ? x : x * rsqrt;
+}
+
+/*
+ * One Newton-Raphson step refining the reciprocal square root estimate `est` of `x`.
+ */
+template <typename T>
+inline T rsqrt_newton_step(const T &x, const T &est)
+{
+    return est * (1.5f - 0.5f * x * (est * est));
+}
+
+/*
+ * Reciprocal square root of a positive value, computed according to `Policy::RSQRT`.
+ *
+ * The SSE estimate is only usable for normal f32 values: it's INFINITY for denormals and 0 for INFINITY, which the
+ * Newton-Raphson step turns into -INFINITY or NaN. Values outside of [FLT_MIN, FLT_MAX] use `1 / sqrtf(x)` instead.
+ */
+template <typename Policy = MathPolicy>
+inline f32 lane_rsqrt(f32 x)
+{
+    if constexpr (Policy::RSQRT == RSQRT_GEKKO)
+    {
+        return (f32) gekko_rsqrt(x);
+    }
+    else if constexpr (Policy::RSQRT == RSQRT_FAST)
+    {
+#ifdef EIGEN_VECTORIZE_SSE
+        if (x >= FLT_MIN && x <= FLT_MAX) return rsqrt_newton_step(x, _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x))));
+        return 1.f / sqrtf(x);
+#else
+        return 1.f / sqrtf(x);
+#endif
+    }
+    else
+    {
+        return 1.f / sqrtf(x);
+    }
+}
+
+template <typename Policy = MathPolicy>
+inline LaneArray lane_rsqrt(const LaneArray &x)
+{
+    if constexpr (Policy::RSQRT == RSQRT_GEKKO)
+    {
+        // The table lookup is done one lane at a time, but the Newton-Raphson steps run on all lanes at once, in the
+        // same order as `gekko_rsqrt()` so the results match it exactly
+        using LaneArrayF64 = Eigen::Array<f64, LANE_COUNT, 1>;
+        LaneArrayF64 x_f64 = x.cast<f64>();
+        LaneArrayF64 guess = x_f64.unaryExpr([](f64 lane) { return gekko_frsqrte(lane); });
+        for (s32 i = 0; i < 3; i++)
+        {
+            guess = 0.5 * guess * (3.0 - x_f64 * (guess * guess));
+        }
+        LaneArray rsqrt = guess.cast<f32>();
+        return lane_select(x == INFINITY, lane_splat<LaneArray>(0.f), rsqrt);
+    }
+    else if constexpr (Policy::RSQRT == RSQRT_FAST)
+    {
+#ifdef EIGEN_VECTORIZE_SSE
+        __m128 x_lanes = _mm_load_ps(x.data());
+        __m128 in_range = _mm_and_ps(_mm_cmpge_ps(x_lanes, _mm_set1_ps(FLT_MIN)),
+                                     _mm_cmple_ps(x_lanes, _mm_set1_ps(FLT_MAX)));
+        LaneArray est;
+        _mm_store_ps(est.data(), _mm_rsqrt_ps(x_lanes));
+        LaneArray rsqrt = rsqrt_newton_step(x, est);
+        if (_mm_movemask_ps(in_range) == 0xf) return rsqrt;
+
+        // Only pay for the exact fallback when some lane is zero, denormal, infinite, negative, or NaN
+        LaneArray libm_rsqrt = 1.f / lane_sqrt(x);
+        LaneArray result;
+        _mm_store_ps(result.data(), _mm_or_ps(_mm_and_ps(in_range, _mm_load_ps(rsqrt.data())),
+                                              _mm_andnot_ps(in_range, _mm_load_ps(libm_rsqrt.data()))));
+        return result;
+#else
+        return 1.f / lane_sqrt(x);
+#endif
+    }
+    else
+    {
+        return 1.f / lane_sqrt(x);
+    }
+}
+
+/*
+ * Reciprocal square root with the semantics of `math_rsqrt()`: INFINITY unless `x` is positive.
+ */
+template <typename T>
+inline T lane_math_rsqrt(const T &x)
+{
+    return lane_select(x > 0.f, lane_rsqrt(x), lane_splat<T>(INFINITY));
+}
+
+/*
+ * Normalize (x, y, z) and output its original length, or zero both if the length isn't positive.
+ *
+ * Outputs may alias inputs.
+ */
+struct NormalizeLenKernel
+{
+    template <typename T>
+    void operator()(const T &x, const T &y, const T &z, T &out_x, T &out_y, T &out_z, T &out_len) const
+    {
+        T len_sq = x * x + y * y + z * z;
+        T inv_len = lane_rsqrt(len_sq);
+        T zero = lane_splat<T>(0.f);
+        out_x = lane_select(len_sq > 0.f, inv_len * x, zero);
+        out_y = lane_select(len_sq > 0.f, inv_len * y, zero);
+        out_z = lane_select(len_sq > 0.f, inv_len * z, zero);
+        out_len = lane_select(len_sq > 0.f, len_sq * inv_len, zero);
+    }
+};
+
+/*
+ * Scale (x, y, z) to length `len`, or zero it if its length isn't positive.
+ *
+ * Outputs may alias inputs.
+ */
+struct SetLenKernel
+{
+    template <typename T>
+    void operator()(f32 len, const T &x, const T &y, const T &z, T &out_x, T &out_y, T &out_z) const
+    {
+        // Original source checks if it's positive, should be unnecessary
+        T len_sq = x * x + y * y + z * z;
+        T scale = lane_rsqrt(len_sq) * len;
+        T zero = lane_splat<T>(0.f);
+        out_x = lane_select(len_sq > 0.f, scale * x, zero);
+        out_y = lane_select(len_sq > 0.f, scale * y, zero);
+        out_z = lane_select(len_sq > 0.f, scale * z, zero);
+    }
+};
+
+/*
+ * Dot product of the normals of (x1, y1, z1) and (x2, y2, z2), see `vec_dot_normalized()`.
+ */
+struct DotNormalizedKernel
+{
+    template <typename T>
+    T operator()(const T &x1, const T &y1, const T &z1, const T &x2, const T &y2, const T &z2) const
+    {
+        T dot = x1 * x2 + y1 * y2 + z1 * z2;
+        T len_sq_prod = (x1 * x1 + y1 * y1 + z1 * z1) * (x2 * x2 + y2 * y2 + z2 * z2);
+        return dot * lane_math_rsqrt<T>(len_sq_prod);
+    }
+};
+
+/*
+ * Dot product of the normals of (x1, y1, z1) and (x2, y2, z2), see `vec_dot_normalized_safe()`.
+ */
+struct DotNormalizedSafeKernel
+{
+    template <typename T>
+    T operator()(const T &x1, const T &y1, const T &z1, const T &x2, const T &y2, const T &z2) const
+    {
+        T len1_sq = x1 * x1 + y1 * y1 + z1 * z1;
+        T len2_sq = x2 * x2 + y2 * y2 + z2 * z2;
+        T dot = x1 * x2 + y1 * y2 + z1 * z2;
+        T result = lane_select(dot == 0.f, lane_splat<T>(0.f), dot * lane_math_rsqrt<T>(len1_sq * len2_sq));
+        result = lane_select(len2_sq == INFINITY, lane_splat<T>(INFINITY), result);
+        return lane_select(len1_sq == INFINITY, lane_splat<T>(INFINITY), result);
+    }
+};
+
+/*
+ * Loading and storing LANE_COUNT consecutive elements of a structure-of-arrays vector stream.
+ */
+using LaneMap = Eigen::Map<LaneArray, Eigen::Unaligned>;
+
+inline void vec3f_soa_lanes_load(Vec3fSoa *src, u32 idx, LaneArray &x, LaneArray &y, LaneArray &z)
+{
+    x = LaneMap(&src->x[idx]);
+    y = LaneMap(&src->y[idx]);
+    z = LaneMap(&src->z[idx]);
+}
+
+inline void vec3f_soa_lanes_store(const LaneArray &x, const LaneArray &y, const LaneArray &z, Vec3fSoa *dst, u32 idx)
+{
+    LaneMap(&dst->x[idx]) = x;
+    LaneMap(&dst->y[idx]) = y;
+    LaneMap(&dst->z[idx]) = z;
+}
+
+/*
+ * LANE_COUNT quaternions with each component in its own lane array.
+ */
+struct QuatLanes
+{
+    LaneArray x;
+    LaneArray y;
+    LaneArray z;
+    LaneArray w;
+};
+
+/*
+ * View of one component of LANE_COUNT consecutive Quat's.
+ */
+using QuatLaneMap = Eigen::Map<LaneArray, Eigen::Unaligned, Eigen::InnerStride<4>>;
+
+static_assert(sizeof(Quat) == 4 * sizeof(f32), "Quat must be tightly packed for QuatLaneMap");
+
+/*
+ * Load LANE_COUNT consecutive Quat's into lanes.
+ */
+inline void quat_lanes_load(Quat *src, QuatLanes &lanes)
+{
+#ifdef EIGEN_VECTORIZE_SSE
+    __m128 x = _mm_loadu_ps(&src[0].x);
+    __m128 y = _mm_loadu_ps(&src[1].x);
+    __m128 z = _mm_loadu_ps(&src[2].x);
+    __m128 w = _mm_loadu_ps(&src[3].x);
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    _mm_store_ps(lanes.x.data(), x);
+    _mm_store_ps(lanes.y.data(), y);
+    _mm_store_ps(lanes.z.data(), z);
+    _mm_store_ps(lanes.w.data(), w);
+#else
+    lanes.x = QuatLaneMap(&src->x);
+    lanes.y = QuatLaneMap(&src->y);
+    lanes.z = QuatLaneMap(&src->z);
+    lanes.w = QuatLaneMap(&src->w);
+#endif
+}
+
+/*
+ * Store lanes to LANE_COUNT consecutive Quat's.
+ */
+inline void quat_lanes_store(const QuatLanes &lanes, Quat *dst)
+{
+#ifdef EIGEN_VECTORIZE_SSE
+    __m128 x = _mm_load_ps(lanes.x.data());
+    __m128 y = _mm_load_ps(lanes.y.data());
+    __m128 z = _mm_load_ps(lanes.z.data());
+    __m128 w = _mm_load_ps(lanes.w.data());
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    _mm_storeu_ps(&dst[0].x, x);
+    _mm_storeu_ps(&dst[1].x, y);
+    _mm_storeu_ps(&dst[2].x, z);
+    _mm_storeu_ps(&dst[3].x, w);
+#else
+    QuatLaneMap(&dst->x) = lanes.x;
+    QuatLaneMap(&dst->y) = lanes.y;
+    QuatLaneMap(&dst->z) = lanes.z;
+    QuatLaneMap(&dst->w) = lanes.w;
+#endif
+}
+
+/*
+ * Quaternion kernels, called with either Quat or QuatLanes.
+ */
+
+template <typename Q>
+inline decltype(Q::x) quat_dot(const Q &quat1, const Q &quat2)
+{
+    return quat1.x * quat2.x + quat1.y * quat2.y + quat1.z * quat2.z + quat1.w * quat2.w;
+}
+
+struct QuatMultKernel
+{
+    template <typename Q>
+    void operator()(const Q &left, const Q &right, Q &out) const
+    {
+        Q result;
+        result.x = left.w * right.x + left.x * right.w + left.y * right.z - left.z * right.y;
+        result.y = left.w * right.y + left.y * right.w + left.z * right.x - left.x * right.z;
+        result.z = left.w * right.z + left.z * right.w + left.x * right.y - left.y * right.x;
+        result.w = left.w * right.w - left.x * right.x - left.y * right.y - left.z * right.z;
+        out = result;
+    }
+};
+
+/*
+ * Normalize a quaternion, leaving it unchanged if it has zero length.
+ */
+struct QuatNormalizeKernel
+{
+    template <typename Q>
+    void operator()(const Q &quat, Q &out) const
+    {
+        using T = decltype(Q::x);
+        T len = lane_sqrt(quat_dot(quat, quat));
+        out.x = lane_select(len > 0.f, quat.x / len, quat.x);
+        out.y = lane_select(len > 0.f, quat.y / len, quat.y);
+        out.z = lane_select(len > 0.f, quat.z / len, quat.z);
+        out.w = lane_select(len > 0.f, quat.w / len, quat.w);
+    }
+};
+
+/*
+ * Spherical linear interpolation along the shortest arc, falling back to linear interpolation when the quaternions
+ * are nearly identical.
+ */
+struct QuatSlerpKernel
+{
+    template <typename Q>
+    void operator()(f32 t, const Q &quat1, const Q &quat2, Q &out) const
+    {
+        using T = decltype(Q::x);
+        constexpr f32 ONE = 1.f - FLT_EPSILON;
+
+        T dot = quat_dot(quat1, quat2);
+        T abs_dot = lane_abs(dot);
+        T theta = lane_acos(abs_dot);
+        T sin_theta = lane_sin(theta);
+        T scale1 = lane_select(abs_dot >= ONE, lane_splat<T>(1.f - t), lane_sin((1.f - t) * theta) / sin_theta);
+        T scale2 = lane_select(abs_dot >= ONE, lane_splat<T>(t), lane_sin(t * theta) / sin_theta);
+        scale2 = lane_select(dot < 0.f, -scale2, scale2);
+
+        out.x = scale1 * quat1.x + scale2 * quat2.x;
+        out.y = scale1 * quat1.y + scale2 * quat2.y;
+        out.z = scale1 * quat1.z + scale2 * quat2.z;
+        out.w = scale1 * quat1.w + scale2 * quat2.w;
+    }
+};
+
+/*
+ * Normalized linear interpolation along the shortest arc. Cheaper than slerp, with the same endpoints but not quite
+ * constant angular velocity.
+ */
+struct QuatNlerpKernel
+{
+    template <typename Q>
+    void operator()(f32 t, const Q &quat1, const Q &quat2, Q &out) const
+    {
+        using T = decltype(Q::x);
+        T scale2 = lane_select(quat_dot(quat1, quat2) < 0.f, lane_splat<T>(-t), lane_splat<T>(t));
+
+        Q result;
+        result.x = (1.f - t) * quat1.x + scale2 * quat2.x;
+        result.y = (1.f - t) * quat1.y + scale2 * quat2.y;
+        result.z = (1.f - t) * quat1.z + scale2 * quat2.z;
+        result.w = (1.f - t) * quat1.w + scale2 * quat2.w;
+        T inv_len = lane_rsqrt(quat_dot(result, result));
+
+        out.x = result.x * inv_len;
+        out.y = result.y * inv_len;
+        out.z = result.z * inv_len;
+        out.w = result.w * inv_len;
+    }
+};
+
+/*
+ * Rotation matrix (square part only) of a unit quaternion.
+ */
+struct MtxFromQuatKernel
+{
+    template <typename Q, typename T = decltype(Q::x)>
+    void operator()(const Q &quat, T (&out)[3][3]) const
+    {
+        T tx = 2.f * quat.x;
+        T ty = 2.f * quat.y;
+        T tz = 2.f * quat.z;
+        T twx = tx * quat.w;
+        T twy = ty * quat.w;
+        T twz = tz * quat.w;
+        T txx = tx * quat.x;
+        T txy = ty * quat.x;
+        T txz = tz * quat.x;
+        T tyy = ty * quat.y;
+        T tyz = tz * quat.y;
+        T tzz = tz * quat.z;
+
+        out[0][0] = 1.f - (tyy + tzz);
+        out[0][1] = txy - twz;
+        out[0][2] = txz + twy;
+        out[1][0] = txy + twz;
+        out[1][1] = 1.f - (txx + tzz);
+        out[1][2] = tyz - twx;
+        out[2][0] = txz - twy;
+        out[2][1] = tyz + twx;
+        out[2][2] = 1.f - (txx + tyy);
+    }
+};
+
+/*
+ * Apply a kernel taking `Q` quaternion arguments to `count` quaternions from each of the `srcs` arrays, writing the
+ * results to `dst`.
+ *
+ * Full groups of LANE_COUNT quaternions are processed with lane arrays and the remainder one at a time. `dst` may be
+ * one of the source arrays.
+ */
+template <typename Kernel>
+inline void quat_batch(Quat *dst, Quat *src, u32 count, Kernel kernel)
+{
+    u32 i = 0;
+    for (; i + LANE_COUNT <= count; i += LANE_COUNT)
+    {
+        QuatLanes quat, out;
+        quat_lanes_load(&src[i], quat);
+        kernel(quat, out);
+        quat_lanes_store(out, &dst[i]);
+    }
+    for (; i < count; i++) kernel(src[i], dst[i]);
+}
+
+template <typename Kernel>
+inline void quat_batch(Quat *dst, Quat *src1, Quat *src2, u32 count, Kernel kernel)
+{
+    u32 i = 0;
+    for (; i + LANE_COUNT <= count; i += LANE_COUNT)
+    {
+        QuatLanes quat1, quat2, out;
+        quat_lanes_load(&src1[i], quat1);
+        quat_lanes_load(&src2[i], quat2);
+        kernel(quat1, quat2, out);
+        quat_lanes_store(out, &dst[i]);
+    }
+    for (; i < count; i++) kernel(src1[i], src2[i], dst[i]);
+}
+
 /*
  * Convert a s16 angle to radians.
  *
@@ -114,73 +961,539 @@ inline f64 s16_to_radians(s16 angle)
  */
 inline s16 radians_to_s16(f64 angle_rad)
 {
-    return angle_rad * 0x8000 / M_PI;
+    // Truncate through s32 so that an angle of exactly pi wraps around to -0x8000
+    return (s32) (angle_rad * 0x8000 / M_PI);
+}
+
+/*
+ * Quarter-wave sine table indexed directly by s16 angle, like the original game uses for its trig functions.
+ *
+ * SIN_TABLE[i] = sin(i * (pi / 2) / 0x4000) for i in [0, 0x4000]. The rest of the period is derived by symmetry.
+ * The table is generated at compile-time rather than copied from the game.
+ */
+constexpr u32 SIN_TABLE_LEN = 0x4000 + 1;
+
+struct SinTable
+{
+    f32 vals[SIN_TABLE_LEN];
+};
+
+/*
+ * Compile-time sine and cosine Taylor series. Accurate to double precision for |x| <= pi/4.
+ */
+
+constexpr f64 taylor_sin(f64 x)
+{
+    f64 term = x;
+    f64 sum = x;
+    for (s32 n = 1; n <= 10; n++)
+    {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr f64 taylor_cos(f64 x)
+{
+    f64 term = 1.0;
+    f64 sum = 1.0;
+    for (s32 n = 1; n <= 10; n++)
+    {
+        term *= -x * x / ((2 * n - 1) * (2 * n));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr SinTable gen_sin_table()
+{
+    SinTable table{};
+    for (u32 i = 0; i < SIN_TABLE_LEN; i++)
+    {
+        // Keep the Taylor series argument within [0, pi/4] by using sin(x) = cos(pi/2 - x) past the eighth-turn
+        if (i <= 0x2000) table.vals[i] = (f32) taylor_sin(i * M_PI / 0x8000);
+        else table.vals[i] = (f32) taylor_cos((0x4000 - i) * M_PI / 0x8000);
+    }
+    return table;
+}
+
+constexpr SinTable SIN_TABLE = gen_sin_table();
+
+inline f32 table_sin(s16 angle)
+{
+    u16 idx = (u16) angle & 0x3fff;
+    switch ((u16) angle >> 14)
+    {
+        case 0:
+            return SIN_TABLE.vals[idx];
+        case 1:
+            return SIN_TABLE.vals[0x4000 - idx];
+        case 2:
+            return -SIN_TABLE.vals[idx];
+        default:
+            return -SIN_TABLE.vals[0x4000 - idx];
+    }
+}
+
+/*
+ * Arctangent table used to compute atan2 as a s16 angle without libm.
+ *
+ * ATAN_TABLE[k] = atan(k / ATAN_TABLE_STEPS) for k in [0, ATAN_TABLE_STEPS].
+ */
+constexpr u32 ATAN_TABLE_STEPS = 32;
+
+struct AtanTable
+{
+    f64 vals[ATAN_TABLE_STEPS + 1];
+};
+
+constexpr f64 newton_sqrt(f64 x)
+{
+    if (x == 0.0) return 0.0;
+    f64 guess = x > 1.0 ? x : 1.0;
+    for (s32 i = 0; i < 64; i++)
+    {
+        guess = (guess + x / guess) / 2.0;
+    }
+    return guess;
+}
+
+/*
+ * Compile-time arctangent for x in [0, 1].
+ *
+ * Halves the angle twice with atan(x) = 2 * atan(x / (1 + sqrt(1 + x^2))) to bring it under 0.2, then sums the
+ * Taylor series.
+ */
+constexpr f64 taylor_atan(f64 x)
+{
+    for (s32 i = 0; i < 2; i++)
+    {
+        x = x / (1.0 + newton_sqrt(1.0 + x * x));
+    }
+
+    f64 term = x;
+    f64 sum = x;
+    for (s32 n = 1; n <= 12; n++)
+    {
+        term *= -x * x;
+        sum += term / (2 * n + 1);
+    }
+    return 4.0 * sum;
+}
+
+constexpr AtanTable gen_atan_table()
+{
+    AtanTable table{};
+    for (u32 k = 0; k <= ATAN_TABLE_STEPS; k++)
+    {
+        table.vals[k] = taylor_atan((f64) k / ATAN_TABLE_STEPS);
+    }
+    return table;
+}
+
+constexpr AtanTable ATAN_TABLE = gen_atan_table();
+
+/*
+ * Four quadrant arctangent as a s16 angle.
+ *
+ * The angle is reduced to the first octant, then split into a table angle and a small residual angle using
+ * atan(t) = atan(c) + atan((t - c) / (1 + t * c)). The residual is below 1/64 so a few Taylor series terms
+ * are accurate to double precision. The octant is restored in radians before truncating to s16, so that the
+ * result rounds the same way as the libm version near multiples of 0x4000.
+ */
+inline s16 table_atan2(f64 y, f64 x)
+{
+    f64 abs_x = fabs(x);
+    f64 abs_y = fabs(y);
+
+    // Let libm sort out zeros, infinities, and NaNs
+    if (!(abs_x < INFINITY && abs_y < INFINITY) || (abs_x == 0.0 && abs_y == 0.0))
+    {
+        return radians_to_s16(atan2(y, x));
+    }
+
+    bool swap = abs_y > abs_x;
+    f64 t = swap ? abs_x / abs_y : abs_y / abs_x;
+
+    u32 k = (u32) (t * ATAN_TABLE_STEPS + 0.5);
+    f64 c = (f64) k / ATAN_TABLE_STEPS;
+    f64 r = (t - c) / (1.0 + t * c);
+    f64 r2 = r * r;
+    f64 atan_r = r * (1.0 - r2 * (1.0 / 3.0 - r2 * (1.0 / 5.0 - r2 * (1.0 / 7.0))));
+
+    f64 angle_rad = ATAN_TABLE.vals[k] + atan_r;
+    // Subtract from pi/2 and pi with the extra precision of their low-order parts, like libm does
+    if (swap) angle_rad = M_PI / 2 - (angle_rad - 6.123233995736766036e-17);
+    if (x < 0.0) angle_rad = M_PI - (angle_rad - 1.224646799147353207e-16);
+    if (std::signbit(y)) angle_rad = -angle_rad;
+
+    return radians_to_s16(angle_rad);
+}
+
+/*
+ * Right-multiply `m` by a rotation about a single axis, in place.
+ *
+ * Such a rotation only mixes two basis columns: column `a` becomes `cos * a + sin * b` and column `b` becomes
+ * `cos * b - sin * a`. The third column and the translation are untouched.
+ *
+ * `m` is a Mtx, or a 3x3 array of lane arrays holding the square parts of LANE_COUNT matrices.
+ */
+template <typename M, typename T>
+static inline void mtx_rotate_cols(M &m, s32 a, s32 b, const T &sin, const T &cos)
+{
+    // Adding the product with -sin is exactly the same as subtracting the product with sin, but keeps GCC's SLP
+    // vectorizer from pairing the two expressions into a fused multiply-subtract-add, which it does even with
+    // -ffp-contract=off
+    T neg_sin = -sin;
+    for (s32 row = 0; row < 3; row++)
+    {
+        T col_a = m[row][a];
+        T col_b = m[row][b];
+        m[row][a] = cos * col_a + sin * col_b;
+        m[row][b] = cos * col_b + neg_sin * col_a;
+    }
+}
+
+/*
+ * Set the square part of `m` to a rotation about a single axis, writing every element directly.
+ */
+template <typename M, typename T>
+static inline void mtx_sq_from_rotate_cols(M &m, s32 a, s32 b, s32 axis, const T &sin, const T &cos)
+{
+    for (s32 row = 0; row < 3; row++)
+    {
+        for (s32 col = 0; col < 3; col++) m[row][col] = lane_splat<T>(0.f);
+    }
+    m[axis][axis] = lane_splat<T>(1.f);
+    m[a][a] = cos;
+    m[b][a] = sin;
+    m[a][b] = -sin;
+    m[b][b] = cos;
+}
+
+// Column pairs mixed by a rotation about X, Y, and Z respectively, as in `mtxa_rotate_x/y/z()`
+static constexpr s32 ROT_COLS[3][2] = {{1, 2}, {2, 0}, {0, 1}};
+
+// Axes in the order their rotations are applied for each EulerOrder
+static constexpr s32 EULER_ORDER_AXES[6][3] = {
+    {0, 1, 2}, // EULER_ORDER_XYZ
+    {0, 2, 1}, // EULER_ORDER_XZY
+    {1, 0, 2}, // EULER_ORDER_YXZ
+    {1, 2, 0}, // EULER_ORDER_YZX
+    {2, 0, 1}, // EULER_ORDER_ZXY
+    {2, 1, 0}, // EULER_ORDER_ZYX
+};
+
+/*
+ * Set the square part of `m` to the product of the X, Y, and Z rotations with sines and cosines `sin_cos[axis]`,
+ * applied in `order`. Identical to setting it to the first rotation and then rotating by the other two.
+ */
+template <typename M, typename T>
+static inline void mtx_sq_from_euler(M &m, const T (&sin_cos)[3][2], EulerOrder order)
+{
+    const s32 *axes = EULER_ORDER_AXES[order];
+
+    // The first rotation is written directly, the other two are applied in place
+    s32 axis = axes[0];
+    mtx_sq_from_rotate_cols(m, ROT_COLS[axis][0], ROT_COLS[axis][1], axis, sin_cos[axis][0], sin_cos[axis][1]);
+    for (s32 i = 1; i < 3; i++)
+    {
+        axis = axes[i];
+        mtx_rotate_cols(m, ROT_COLS[axis][0], ROT_COLS[axis][1], sin_cos[axis][0], sin_cos[axis][1]);
+    }
+}
+
+/*
+ * Store the square parts of LANE_COUNT matrices held in lanes to `out_mtxs`, zeroing their translations.
+ */
+static inline void mtx_sq_lanes_store(const LaneArray (&sq)[3][3], Mtx *out_mtxs)
+{
+    // Each group of lanes holds one row of four matrices; transpose it into rows of each matrix
+    for (s32 row = 0; row < 3; row++)
+    {
+#ifdef EIGEN_VECTORIZE_SSE
+        __m128 col0 = _mm_load_ps(sq[row][0].data());
+        __m128 col1 = _mm_load_ps(sq[row][1].data());
+        __m128 col2 = _mm_load_ps(sq[row][2].data());
+        __m128 col3 = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(col0, col1, col2, col3);
+        _mm_storeu_ps(out_mtxs[0][row], col0);
+        _mm_storeu_ps(out_mtxs[1][row], col1);
+        _mm_storeu_ps(out_mtxs[2][row], col2);
+        _mm_storeu_ps(out_mtxs[3][row], col3);
+#else
+        for (u32 lane = 0; lane < LANE_COUNT; lane++)
+        {
+            out_mtxs[lane][row][0] = sq[row][0][lane];
+            out_mtxs[lane][row][1] = sq[row][1][lane];
+            out_mtxs[lane][row][2] = sq[row][2][lane];
+            out_mtxs[lane][row][3] = 0.f;
+        }
+#endif
+    }
+}
+
+static inline void mtx_rotate_cols(Mtx &m, s32 a, s32 b, s16 angle)
+{
+    f32 sin_cos[2];
+    math_sin_cos_v(angle, sin_cos);
+    mtx_rotate_cols(m, a, b, sin_cos[0], sin_cos[1]);
+}
+
+/*
+ * Right-multiply `m` by a translation matrix, in place.
+ */
+static inline void mtx_translate_xyz(Mtx &m, f32 x, f32 y, f32 z)
+{
+    EigenMtxMap emtx(emap_mtx(&m));
+    emtx.col(3) += emtx.leftCols<3>() * Eigen::Vector3f(x, y, z);
+}
+
+/*
+ * Right-multiply `m` by a scale matrix, in place.
+ */
+static inline void mtx_scale_xyz(Mtx &m, f32 x, f32 y, f32 z)
+{
+    for (s32 row = 0; row < 3; row++)
+    {
+        m[row][0] *= x;
+        m[row][1] *= y;
+        m[row][2] *= z;
+    }
+}
+
+/*
+ * Record a Matrix A operation if deferred mode is enabled.
+ *
+ * Returns false if the operation should be applied immediately instead.
+ */
+static inline bool mtxa_defer(MtxaOpType type, s16 angle, f32 x, f32 y, f32 z)
+{
+    if (!gs->mtxa_deferred) return false;
+    if (gs->mtxa_op_count == MTXA_OP_BUFFER_LEN) mtxa_flush();
+    gs->mtxa_ops[gs->mtxa_op_count++] = {type, angle, {x, y, z}};
+    return true;
+}
+
+/*
+ * Drop pending Matrix A operations, for functions which are about to overwrite all of Matrix A anyway.
+ */
+static inline void mtxa_discard_pending()
+{
+    gs->mtxa_op_count = 0;
+}
+
+void mtxa_set_deferred(bool deferred)
+{
+    if (!deferred) mtxa_flush();
+    gs->mtxa_deferred = deferred;
+}
+
+void mtxa_flush()
+{
+    u32 count = gs->mtxa_op_count;
+    if (count == 0) return;
+    gs->mtxa_op_count = 0;
+
+    // Apply every operation to a local copy so that only the final matrix is written back
+    Mtx m;
+    memcpy(m, gs->mtxa_raw, sizeof(Mtx));
+    for (u32 i = 0; i < count; i++)
+    {
+        MtxaOp &op = gs->mtxa_ops[i];
+        switch (op.type)
+        {
+            case MTXA_OP_TRANSLATE:
+                mtx_translate_xyz(m, op.vec.x, op.vec.y, op.vec.z);
+                break;
+            case MTXA_OP_SCALE:
+                mtx_scale_xyz(m, op.vec.x, op.vec.y, op.vec.z);
+                break;
+            case MTXA_OP_ROTATE_X:
+                mtx_rotate_cols(m, 1, 2, op.angle);
+                break;
+            case MTXA_OP_ROTATE_Y:
+                mtx_rotate_cols(m, 2, 0, op.angle);
+                break;
+            case MTXA_OP_ROTATE_Z:
+                mtx_rotate_cols(m, 0, 1, op.angle);
+                break;
+        }
+    }
+    memcpy(gs->mtxa_raw, m, sizeof(Mtx));
+}
+
+static inline void mtxa_from_rotate_cols(s32 a, s32 b, s32 axis, s16 angle)
+{
+    mtxa_discard_pending();
+    f32 sin_cos[2];
+    math_sin_cos_v(angle, sin_cos);
+    mtx_sq_from_rotate_cols(gs->mtxa_raw, a, b, axis, sin_cos[0], sin_cos[1]);
+    gs->mtxa_raw[0][3] = 0.f;
+    gs->mtxa_raw[1][3] = 0.f;
+    gs->mtxa_raw[2][3] = 0.f;
+}
+
+void math_init() {}
+
+template <typename Policy>
+f32 MathCore<Policy>::sqrt(f64 x)
+{
+    if (x > 0.f)
+    {
+        if constexpr (Policy::RSQRT == RSQRT_GEKKO) return (f32) gekko_sqrt(x, gekko_rsqrt(x));
+        else return sqrtf((f32) x);
+    }
+    return 0.f;
+}
+
+template <typename Policy>
+f32 MathCore<Policy>::rsqrt(f64 x)
+{
+    if (x > 0.f)
+    {
+        if constexpr (Policy::RSQRT == RSQRT_GEKKO) return (f32) gekko_rsqrt(x);
+        else return lane_rsqrt<Policy>((f32) x);
+    }
+    return INFINITY;
+}
+
+template <typename Policy>
+f32 MathCore<Policy>::sqrt_rsqrt(f64 x, f32 *out_sqrt)
+{
+    if (x > 0.f)
+    {
+        if constexpr (Policy::RSQRT == RSQRT_GEKKO)
+        {
+            f64 rsqrt = gekko_rsqrt(x);
+            *out_sqrt = (f32) gekko_sqrt(x, rsqrt);
+            return (f32) rsqrt;
+        }
+        else if constexpr (Policy::RSQRT == RSQRT_FAST)
+        {
+            // Outside of the range where the estimate is used, the product would be 0 * INFINITY or INFINITY * 0
+            f32 x_f32 = (f32) x;
+            f32 rsqrt = lane_rsqrt<Policy>(x_f32);
+            *out_sqrt = x_f32 >= FLT_MIN && x_f32 <= FLT_MAX ? x_f32 * rsqrt : sqrtf(x_f32);
+            return rsqrt;
+        }
+        else
+        {
+            *out_sqrt = sqrtf((f32) x);
+            return 1.f / *out_sqrt;
+        }
+    }
+    *out_sqrt = 0.f;
+    return INFINITY;
+}
+
+template <typename Policy>
+f32 MathCore<Policy>::sin(s16 angle)
+{
+    if constexpr (Policy::TRIG_TABLE) return table_sin(angle);
+    else return (f32) ::sin(s16_to_radians(angle));
+}
+
+template <typename Policy>
+void MathCore<Policy>::sin_cos_v(s16 angle, f32 *out_sin_cos)
+{
+    if constexpr (Policy::TRIG_TABLE)
+    {
+        out_sin_cos[0] = table_sin(angle);
+        out_sin_cos[1] = table_sin(angle + 0x4000);
+    }
+    else
+    {
+        f64 angle_rad = s16_to_radians(angle);
+        out_sin_cos[0] = (f32) ::sin(angle_rad);
+        out_sin_cos[1] = (f32) ::cos(angle_rad);
+    }
+}
+
+template <typename Policy>
+f32 MathCore<Policy>::tan(s16 angle)
+{
+    if constexpr (Policy::TRIG_TABLE)
+    {
+        // The cosine is ±0 at ±0x4000, where dividing would give an infinity whose sign depends on the sign of the
+        // zero. Use libm there instead, which gives a huge finite value with the sign of the sine
+        f32 cos = table_sin(angle + 0x4000);
+        if (cos == 0.f) return (f32) ::tan(s16_to_radians(angle));
+        return table_sin(angle) / cos;
+    }
+    else
+    {
+        return (f32) ::tan(s16_to_radians(angle));
+    }
+}
+
+template <typename Policy>
+s16 MathCore<Policy>::atan2(f64 y, f64 x)
+{
+    if constexpr (Policy::TRIG_TABLE) return table_atan2(y, x);
+    else return radians_to_s16(::atan2(y, x));
+}
+
+template <typename Policy>
+s16 MathCore<Policy>::atan(f64 x)
+{
+    if constexpr (Policy::TRIG_TABLE) return table_atan2(x, 1.0);
+    else return radians_to_s16(::atan(x));
 }
 
-void math_init() {}
+template struct MathCore<MathPolicyAccurate>;
+template struct MathCore<MathPolicyFast>;
+template struct MathCore<MathPolicyReference>;
 
 f32 math_sqrt(f64 x)
 {
-    if (x > 0.f) return sqrtf((f32) x);
-    return 0.f;
+    return MathCore<MathPolicy>::sqrt(x);
 }
 
 f32 math_rsqrt(f64 x)
 {
-    if (x > 0.f) return 1.f / sqrtf((f32) x);
-    return INFINITY;
+    return MathCore<MathPolicy>::rsqrt(x);
 }
 
 f32 math_sqrt_rsqrt(f64 x, f32 *out_sqrt)
 {
-    if (x > 0.f)
-    {
-        *out_sqrt = sqrtf((f32) x);
-        return 1.f / *out_sqrt;
-    }
-    *out_sqrt = 0.f;
-    return INFINITY;
+    return MathCore<MathPolicy>::sqrt_rsqrt(x, out_sqrt);
+}
+
+f64 math_frsqrte(f64 x)
+{
+    return gekko_frsqrte(x);
 }
 
 f32 math_sin(s16 angle)
 {
-    // This is normally performed with a table lookup.
-    return (f32) sin(s16_to_radians(angle));
+    return MathCore<MathPolicy>::sin(angle);
 }
 
 void math_sin_cos_v(s16 angle, f32 *out_sin_cos)
 {
-    f64 angle_rad = s16_to_radians(angle);
-    out_sin_cos[0] = (f32) sin(angle_rad);
-    out_sin_cos[1] = (f32) cos(angle_rad);
+    MathCore<MathPolicy>::sin_cos_v(angle, out_sin_cos);
 }
 
 f32 math_tan(s16 angle)
 {
-    return tan(s16_to_radians(angle));
+    return MathCore<MathPolicy>::tan(angle);
 }
 
 s16 math_atan2(f64 y, f64 x)
 {
-    return radians_to_s16(atan2(y, x));
+    return MathCore<MathPolicy>::atan2(y, x);
 }
 
 s16 math_atan(f64 x)
 {
-    return radians_to_s16(atan(x));
+    return MathCore<MathPolicy>::atan(x);
 }
 
 f32 vec_dot_normalized_safe(Vec3f *vec1, Vec3f *vec2)
 {
-    f32 len1_sq = VEC_LEN_SQ(*vec1);
-    f32 len2_sq = VEC_LEN_SQ(*vec2);
-    if (len1_sq == INFINITY || len2_sq == INFINITY) return INFINITY;
-
-    f32 dot = VEC_DOT(*vec1, *vec2);
-    if (dot == 0.f) return 0.f;
-
-    f32 inv_len_prod = math_rsqrt(len1_sq * len2_sq);
-    return dot * inv_len_prod;
+    return DotNormalizedSafeKernel()(vec1->x, vec1->y, vec1->z, vec2->x, vec2->y, vec2->z);
 }
 
 void ray_scale(f32 scale, Vec3f *ray_start, Vec3f *ray_end, Vec3f *out_ray_end)
@@ -191,62 +1504,168 @@ void ray_scale(f32 scale, Vec3f *ray_start, Vec3f *ray_end, Vec3f *out_ray_end)
 
 void vec_set_len(f32 len, Vec3f *vec, Vec3f *out_vec)
 {
-    f32 len_sq = VEC_LEN_SQ(*vec);
+    SetLenKernel()(len, vec->x, vec->y, vec->z, out_vec->x, out_vec->y, out_vec->z);
+}
+
+f32 vec_normalize_len(Vec3f *vec)
+{
+    f32 len;
+    NormalizeLenKernel()(vec->x, vec->y, vec->z, vec->x, vec->y, vec->z, len);
+    return len;
+}
+
+f32 vec_dot_normalized(Vec3f *vec1, Vec3f *vec2)
+{
+    return DotNormalizedKernel()(vec1->x, vec1->y, vec1->z, vec2->x, vec2->y, vec2->z);
+}
 
-    // Original source checks if it's positive, should be unnecessary
-    if (len_sq > 0.f)
+void vec_normalize_len_batch(Vec3f *vecs, f32 *out_lens, u32 count)
+{
+    u32 i = 0;
+    for (; i + LANE_COUNT <= count; i += LANE_COUNT)
     {
-        f32 inv_len = math_rsqrt(len_sq);
-        f32 scale = inv_len * len;
-        *out_vec = VEC_SCALE(scale, *vec);
+        LaneArray x, y, z, len;
+        vec3f_lanes_load(&vecs[i], x, y, z);
+        NormalizeLenKernel()(x, y, z, x, y, z, len);
+        vec3f_lanes_store(x, y, z, &vecs[i]);
+        if (out_lens != nullptr) LaneMap(out_lens + i) = len;
     }
-    else
+
+    for (; i < count; i++)
     {
-        *out_vec = VEC_ZERO;
+        f32 len = vec_normalize_len(&vecs[i]);
+        if (out_lens != nullptr) out_lens[i] = len;
     }
 }
 
-f32 vec_normalize_len(Vec3f *vec)
+void vec_normalize_len_soa(Vec3fSoa *vecs, f32 *out_lens, u32 count)
 {
-    f32 len_sq = VEC_LEN_SQ(*vec);
-    if (len_sq > 0.f)
+    u32 i = 0;
+    for (; i + LANE_COUNT <= count; i += LANE_COUNT)
     {
-        f32 inv_len = math_rsqrt(len_sq);
-        *vec = VEC_SCALE(inv_len, *vec);
-        return len_sq * inv_len;
+        LaneArray x, y, z, len;
+        vec3f_soa_lanes_load(vecs, i, x, y, z);
+        NormalizeLenKernel()(x, y, z, x, y, z, len);
+        vec3f_soa_lanes_store(x, y, z, vecs, i);
+        if (out_lens != nullptr) LaneMap(out_lens + i) = len;
     }
 
-    *vec = VEC_ZERO;
-    return 0.f;
+    for (; i < count; i++)
+    {
+        f32 len;
+        NormalizeLenKernel()(vecs->x[i], vecs->y[i], vecs->z[i], vecs->x[i], vecs->y[i], vecs->z[i], len);
+        if (out_lens != nullptr) out_lens[i] = len;
+    }
 }
 
-f32 vec_dot_normalized(Vec3f *vec1, Vec3f *vec2)
+void vec_set_len_batch(f32 len, Vec3f *vecs, Vec3f *out_vecs, u32 count)
+{
+    u32 i = 0;
+    for (; i + LANE_COUNT <= count; i += LANE_COUNT)
+    {
+        LaneArray x, y, z;
+        vec3f_lanes_load(&vecs[i], x, y, z);
+        SetLenKernel()(len, x, y, z, x, y, z);
+        vec3f_lanes_store(x, y, z, &out_vecs[i]);
+    }
+
+    for (; i < count; i++) vec_set_len(len, &vecs[i], &out_vecs[i]);
+}
+
+void vec_set_len_soa(f32 len, Vec3fSoa *vecs, Vec3fSoa *out_vecs, u32 count)
+{
+    u32 i = 0;
+    for (; i + LANE_COUNT <= count; i += LANE_COUNT)
+    {
+        LaneArray x, y, z;
+        vec3f_soa_lanes_load(vecs, i, x, y, z);
+        SetLenKernel()(len, x, y, z, x, y, z);
+        vec3f_soa_lanes_store(x, y, z, out_vecs, i);
+    }
+
+    for (; i < count; i++)
+    {
+        SetLenKernel()(len, vecs->x[i], vecs->y[i], vecs->z[i], out_vecs->x[i], out_vecs->y[i], out_vecs->z[i]);
+    }
+}
+
+/*
+ * Apply a DotNormalizedKernel-like `kernel` to each pair of vectors from two arrays of Vec3f.
+ */
+template <typename Kernel>
+inline void vec_dot_batch(Vec3f *vecs1, Vec3f *vecs2, f32 *out_dots, u32 count, Kernel kernel)
+{
+    u32 i = 0;
+    for (; i + LANE_COUNT <= count; i += LANE_COUNT)
+    {
+        LaneArray x1, y1, z1, x2, y2, z2;
+        vec3f_lanes_load(&vecs1[i], x1, y1, z1);
+        vec3f_lanes_load(&vecs2[i], x2, y2, z2);
+        LaneMap(out_dots + i) = kernel(x1, y1, z1, x2, y2, z2);
+    }
+
+    for (; i < count; i++)
+    {
+        out_dots[i] = kernel(vecs1[i].x, vecs1[i].y, vecs1[i].z, vecs2[i].x, vecs2[i].y, vecs2[i].z);
+    }
+}
+
+/*
+ * Apply a DotNormalizedKernel-like `kernel` to each pair of vectors from two vector streams.
+ */
+template <typename Kernel>
+inline void vec_dot_soa(Vec3fSoa *vecs1, Vec3fSoa *vecs2, f32 *out_dots, u32 count, Kernel kernel)
+{
+    u32 i = 0;
+    for (; i + LANE_COUNT <= count; i += LANE_COUNT)
+    {
+        LaneArray x1, y1, z1, x2, y2, z2;
+        vec3f_soa_lanes_load(vecs1, i, x1, y1, z1);
+        vec3f_soa_lanes_load(vecs2, i, x2, y2, z2);
+        LaneMap(out_dots + i) = kernel(x1, y1, z1, x2, y2, z2);
+    }
+
+    for (; i < count; i++)
+    {
+        out_dots[i] = kernel(vecs1->x[i], vecs1->y[i], vecs1->z[i], vecs2->x[i], vecs2->y[i], vecs2->z[i]);
+    }
+}
+
+void vec_dot_normalized_batch(Vec3f *vecs1, Vec3f *vecs2, f32 *out_dots, u32 count)
+{
+    vec_dot_batch(vecs1, vecs2, out_dots, count, DotNormalizedKernel());
+}
+
+void vec_dot_normalized_soa(Vec3fSoa *vecs1, Vec3fSoa *vecs2, f32 *out_dots, u32 count)
+{
+    vec_dot_soa(vecs1, vecs2, out_dots, count, DotNormalizedKernel());
+}
+
+void vec_dot_normalized_safe_batch(Vec3f *vecs1, Vec3f *vecs2, f32 *out_dots, u32 count)
+{
+    vec_dot_batch(vecs1, vecs2, out_dots, count, DotNormalizedSafeKernel());
+}
+
+void vec_dot_normalized_safe_soa(Vec3fSoa *vecs1, Vec3fSoa *vecs2, f32 *out_dots, u32 count)
 {
-    f32 dot = VEC_DOT(*vec1, *vec2);
-    f32 len_sq_prod = VEC_LEN_SQ(*vec1) * VEC_LEN_SQ(*vec2);
-    f32 inv_len_prod = math_rsqrt(len_sq_prod);
-    return dot * inv_len_prod;
+    vec_dot_soa(vecs1, vecs2, out_dots, count, DotNormalizedSafeKernel());
 }
 
 void mtxa_from_identity()
 {
-    EigenMtx emtx(emtx_from_mtxa());
-    emtx.setIdentity();
-    emtx_to_mtxa(emtx);
+    mtxa_discard_pending();
+    emap_mtxa().setIdentity();
 }
 
 void mtx_from_identity(Mtx *mtx)
 {
-    memcpy(mtx, EigenMtx::Identity().data(), sizeof(Mtx));
+    emap_mtx(mtx).setIdentity();
 }
 
 void mtxa_sq_from_identity()
 {
-    EigenMtx emtx(emtx_from_mtxa());
-    Eigen::Vector3f tl = emtx.translation();
-    emtx.setIdentity();
-    emtx.translation() = tl;
-    emtx_to_mtxa(emtx);
+    mtxa_flush();
+    emap_mtxa().leftCols<3>().setIdentity();
 }
 
 void mtxa_from_translate(Vec3f *translate)
@@ -256,28 +1675,25 @@ void mtxa_from_translate(Vec3f *translate)
 
 void mtxa_from_translate_xyz(f32 x, f32 y, f32 z)
 {
-    EigenMtx emtxa(emtx_from_mtxa());
-    emtxa.linear().setIdentity();
-    emtxa.translation() = Eigen::Vector3f(x, y, z);
-    emtx_to_mtxa(emtxa);
+    mtxa_discard_pending();
+    EigenMtxMap emtxa(emap_mtxa());
+    emtxa.leftCols<3>().setIdentity();
+    emtxa.col(3) = Eigen::Vector3f(x, y, z);
 }
 
 void mtxa_from_rotate_x(s16 angle)
 {
-    EigenMtx emtx(Eigen::AngleAxisf(s16_to_radians(angle), Eigen::Vector3f::UnitX()));
-    emtx_to_mtxa(emtx);
+    mtxa_from_rotate_cols(1, 2, 0, angle);
 }
 
 void mtxa_from_rotate_y(s16 angle)
 {
-    EigenMtx emtx(Eigen::AngleAxisf(s16_to_radians(angle), Eigen::Vector3f::UnitY()));
-    emtx_to_mtxa(emtx);
+    mtxa_from_rotate_cols(2, 0, 1, angle);
 }
 
 void mtxa_from_rotate_z(s16 angle)
 {
-    EigenMtx emtx(Eigen::AngleAxisf(s16_to_radians(angle), Eigen::Vector3f::UnitZ()));
-    emtx_to_mtxa(emtx);
+    mtxa_from_rotate_cols(0, 1, 2, angle);
 }
 
 void mtxa_from_mtxb_translate(Vec3f *point)
@@ -287,19 +1703,20 @@ void mtxa_from_mtxb_translate(Vec3f *point)
 
 void mtxa_from_mtxb_translate_xyz(f32 x, f32 y, f32 z)
 {
-    Eigen::Vector3f epoint(x, y, z);
-    EigenMtx emtxb(emtx_from_mtxb());
-    emtxb.translation() = emtxb * epoint;
-    emtx_to_mtxa(emtxb);
+    mtxa_discard_pending();
+    EigenMtxMap emtxa(emap_mtxa());
+    EigenMtxMap emtxb(emap_mtxb());
+    emtxa.leftCols<3>() = emtxb.leftCols<3>();
+    emtxa.col(3) = emtxb.leftCols<3>() * Eigen::Vector3f(x, y, z) + emtxb.col(3);
 }
 
 void mtxa_normalize_basis()
 {
-    EigenMtx emtxa(emtx_from_mtxa());
-    emtxa.linear().col(0).normalize();
-    emtxa.linear().col(1).normalize();
-    emtxa.linear().col(2).normalize();
-    emtx_to_mtxa(emtxa);
+    mtxa_flush();
+    EigenMtxMap emtxa(emap_mtxa());
+    emtxa.col(0).normalize();
+    emtxa.col(1).normalize();
+    emtxa.col(2).normalize();
 }
 
 void mtxa_push()
@@ -308,7 +1725,8 @@ void mtxa_push()
     assert(gs->mtx_stack_ptr > gs->mtx_stack);
     assert(gs->mtx_stack_ptr <= gs->mtx_stack + MTX_STACK_LEN);
 
-    memcpy(--gs->mtx_stack_ptr, &gs->mtxa_raw, sizeof(Mtx));
+    mtxa_flush();
+    mtx_copy_aligned(gs->mtxa_raw, *--gs->mtx_stack_ptr);
 }
 
 void mtxa_pop()
@@ -317,52 +1735,66 @@ void mtxa_pop()
     assert(gs->mtx_stack_ptr >= gs->mtx_stack);
     assert(gs->mtx_stack_ptr < gs->mtx_stack + MTX_STACK_LEN);
 
-    memcpy(&gs->mtxa_raw, gs->mtx_stack_ptr++, sizeof(Mtx));
+    mtxa_discard_pending();
+    mtx_copy_aligned(*gs->mtx_stack_ptr++, gs->mtxa_raw);
 }
 
 void mtxa_to_mtx(Mtx *mtx)
 {
+    mtxa_flush();
     memcpy(mtx, &gs->mtxa_raw, sizeof(Mtx));
 }
 
 void mtxa_from_mtx(Mtx *mtx)
 {
+    mtxa_discard_pending();
     memcpy(&gs->mtxa_raw, mtx, sizeof(Mtx));
 }
 
+void mtxa_to_mtx(AlignedMtx *mtx)
+{
+    mtxa_flush();
+    mtx_copy_aligned(gs->mtxa_raw, mtx->m);
+}
+
+void mtxa_from_mtx(AlignedMtx *mtx)
+{
+    mtxa_discard_pending();
+    mtx_copy_aligned(mtx->m, gs->mtxa_raw);
+}
+
 void mtxa_peek()
 {
     // Assertions do not appear in the original source
     assert(gs->mtx_stack_ptr >= gs->mtx_stack);
     assert(gs->mtx_stack_ptr < gs->mtx_stack + MTX_STACK_LEN);
 
-    memcpy(&gs->mtxa_raw, gs->mtx_stack_ptr, sizeof(Mtx));
+    mtxa_discard_pending();
+    mtx_copy_aligned(*gs->mtx_stack_ptr, gs->mtxa_raw);
 }
 
 void mtxa_sq_to_mtx(Mtx *mtx)
 {
-    EigenMtx emtx(emtx_from_mtx(mtx));
-    EigenMtx emtxa(emtx_from_mtxa());
-    emtx.linear() = emtxa.linear();
-    emtx_to_mtx(emtx, mtx);
+    mtxa_flush();
+    emap_mtx(mtx).leftCols<3>() = emap_mtxa().leftCols<3>();
 }
 
 void mtxa_sq_from_mtx(Mtx *mtx)
 {
-    EigenMtx emtx(emtx_from_mtx(mtx));
-    EigenMtx emtxa(emtx_from_mtxa());
-    emtxa.linear() = emtx.linear();
-    emtx_to_mtxa(emtxa);
+    mtxa_flush();
+    emap_mtxa().leftCols<3>() = emap_mtx(mtx).leftCols<3>();
 }
 
 void mtxa_from_mtxb()
 {
-    memcpy(&gs->mtxa_raw, &gs->mtxb_raw, sizeof(Mtx));
+    mtxa_discard_pending();
+    mtx_copy_aligned(gs->mtxb_raw, gs->mtxa_raw);
 }
 
 void mtxa_to_mtxb()
 {
-    memcpy(&gs->mtxb_raw, &gs->mtxa_raw, sizeof(Mtx));
+    mtxa_flush();
+    mtx_copy_aligned(gs->mtxa_raw, gs->mtxb_raw);
 }
 
 void mtx_copy(Mtx *src, Mtx *dst)
@@ -370,37 +1802,154 @@ void mtx_copy(Mtx *src, Mtx *dst)
     memcpy(dst, src, sizeof(Mtx));
 }
 
+#ifndef NDEBUG
+
+/*
+ * Check whether the basis vectors of `mtx` are orthogonal with squared length `len_sq`, i.e. whether `mtx` is a
+ * rotation with uniform scale sqrt(`len_sq`). Only used to validate the specialized inverses in debug builds.
+ */
+static bool mtx_is_uniform_scale_rotation(Mtx *mtx, f32 len_sq)
+{
+    constexpr f32 TOLERANCE = 1e-3f;
+    Eigen::Matrix3f basis = emap_mtx(mtx).leftCols<3>();
+    Eigen::Matrix3f gram = basis.transpose() * basis;
+    return (gram - Eigen::Matrix3f::Identity() * len_sq).cwiseAbs().maxCoeff() <= TOLERANCE * len_sq;
+}
+
+#endif
+
 void mtxa_invert()
 {
-    emtx_to_mtxa(emtx_from_mtxa().inverse());
+    mtxa_flush();
+    Mtx &m = gs->mtxa_raw;
+
+    // Adjugate of the square part
+    f32 adj00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+    f32 adj01 = m[0][2] * m[2][1] - m[0][1] * m[2][2];
+    f32 adj02 = m[0][1] * m[1][2] - m[0][2] * m[1][1];
+    f32 adj10 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+    f32 adj11 = m[0][0] * m[2][2] - m[0][2] * m[2][0];
+    f32 adj12 = m[0][2] * m[1][0] - m[0][0] * m[1][2];
+    f32 adj20 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+    f32 adj21 = m[0][1] * m[2][0] - m[0][0] * m[2][1];
+    f32 adj22 = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+
+    f32 inv_det = 1.f / (m[0][0] * adj00 + m[0][1] * adj10 + m[0][2] * adj20);
+    f32 tx = m[0][3];
+    f32 ty = m[1][3];
+    f32 tz = m[2][3];
+
+    m[0][0] = adj00 * inv_det;
+    m[0][1] = adj01 * inv_det;
+    m[0][2] = adj02 * inv_det;
+    m[1][0] = adj10 * inv_det;
+    m[1][1] = adj11 * inv_det;
+    m[1][2] = adj12 * inv_det;
+    m[2][0] = adj20 * inv_det;
+    m[2][1] = adj21 * inv_det;
+    m[2][2] = adj22 * inv_det;
+
+    // New translation is the old one transformed by the inverse and negated
+    m[0][3] = -(m[0][0] * tx + m[0][1] * ty + m[0][2] * tz);
+    m[1][3] = -(m[1][0] * tx + m[1][1] * ty + m[1][2] * tz);
+    m[2][3] = -(m[2][0] * tx + m[2][1] * ty + m[2][2] * tz);
+}
+
+void mtxa_rigid_invert()
+{
+    mtxa_flush();
+
+    // Assertions do not appear in the original source
+    assert(mtx_is_uniform_scale_rotation(&gs->mtxa_raw, 1.f));
+
+    // The inverse of a rotation is its transpose, which is how the game inverts rigid matrices
+    mtxa_transpose();
+}
+
+void mtxa_uniform_scale_invert()
+{
+    mtxa_flush();
+    Mtx &m = gs->mtxa_raw;
+
+    // For a rotation R scaled by s, the inverse is R^T / s = (sR)^T / s^2
+    f32 scale_sq = m[0][0] * m[0][0] + m[1][0] * m[1][0] + m[2][0] * m[2][0];
+
+    // Assertions do not appear in the original source
+    assert(mtx_is_uniform_scale_rotation(&gs->mtxa_raw, scale_sq));
+
+    mtxa_transpose();
+    f32 inv_scale_sq = 1.f / scale_sq;
+    mtx_scale_xyz(m, inv_scale_sq, inv_scale_sq, inv_scale_sq);
+    m[0][3] /= scale_sq;
+    m[1][3] /= scale_sq;
+    m[2][3] /= scale_sq;
 }
 
 void mtxa_transpose()
 {
-    EigenMtx emtxa(emtx_from_mtxa());
-    emtxa.linear().transposeInPlace();
-    emtxa.translation() = -(emtxa.linear() * emtxa.translation());
-    emtx_to_mtxa(emtxa);
+    mtxa_flush();
+    EigenMtxMap emtxa(emap_mtxa());
+    emtxa.leftCols<3>().transposeInPlace();
+    emtxa.col(3) = -(emtxa.leftCols<3>() * emtxa.col(3));
 }
 
 void mtxa_mult_right(Mtx *mtx)
 {
-    emtx_to_mtxa(emtx_from_mtxa() * emtx_from_mtx(mtx));
+    mtxa_flush();
+    mtx_mult_rows(gs->mtxa_raw, gs->mtxa_raw, *mtx);
 }
 
 void mtxa_mult_left(Mtx *mtx)
 {
-    emtx_to_mtxa(emtx_from_mtx(mtx) * emtx_from_mtxa());
+    mtxa_flush();
+    mtx_mult_rows(gs->mtxa_raw, *mtx, gs->mtxa_raw);
 }
 
 void mtxa_from_mtxb_mult_mtx(Mtx *mtx)
 {
-    emtx_to_mtxa(emtx_from_mtxb() * emtx_from_mtx(mtx));
+    mtxa_discard_pending();
+    mtx_mult_rows(gs->mtxa_raw, gs->mtxb_raw, *mtx);
+}
+
+void mtxa_mult_right(AlignedMtx *mtx)
+{
+    mtxa_flush();
+    mtx_mult_rows<true>(gs->mtxa_raw, gs->mtxa_raw, mtx->m);
+}
+
+void mtxa_mult_left(AlignedMtx *mtx)
+{
+    mtxa_flush();
+    mtx_mult_rows<true>(gs->mtxa_raw, mtx->m, gs->mtxa_raw);
 }
 
 void mtx_mult(Mtx *mtx1, Mtx *mtx2, Mtx *dst)
 {
-    emtx_to_mtx(emtx_from_mtx(mtx1) * emtx_from_mtx(mtx2), dst);
+    mtx_mult_rows(*dst, *mtx1, *mtx2);
+}
+
+void mtx_mult(AlignedMtx *mtx1, AlignedMtx *mtx2, AlignedMtx *dst)
+{
+    mtx_mult_rows<true>(dst->m, mtx1->m, mtx2->m);
+}
+
+void mtx_mult_batch(Mtx *parent, Mtx *children, Mtx *out_mtxs, u32 count)
+{
+    // Copy the parent in case it's part of the output array
+    Mtx left;
+    memcpy(left, parent, sizeof(Mtx));
+    for (u32 i = 0; i < count; i++)
+    {
+        mtx_mult_rows(out_mtxs[i], left, children[i]);
+    }
+}
+
+void mtx_mult_batch_indexed(Mtx *parents, u32 *parent_idxs, Mtx *children, Mtx *out_mtxs, u32 count)
+{
+    for (u32 i = 0; i < count; i++)
+    {
+        mtx_mult_rows(out_mtxs[i], parents[parent_idxs[i]], children[i]);
+    }
 }
 
 void mtxa_translate(Vec3f *point)
@@ -410,10 +1959,8 @@ void mtxa_translate(Vec3f *point)
 
 void mtxa_translate_xyz(f32 x, f32 y, f32 z)
 {
-    Eigen::Vector3f epoint(x, y, z);
-    EigenMtx emtx(emtx_from_mtxa());
-    emtx.translation() = emtx * epoint;
-    emtx_to_mtxa(emtx);
+    if (mtxa_defer(MTXA_OP_TRANSLATE, 0, x, y, z)) return;
+    mtx_translate_xyz(gs->mtxa_raw, x, y, z);
 }
 
 void mtxa_translate_neg(Vec3f *point)
@@ -438,15 +1985,8 @@ void mtxa_scale_s(f32 scale)
 
 void mtxa_scale_xyz(f32 x, f32 y, f32 z)
 {
-    gs->mtxa_raw[0][0] *= x;
-    gs->mtxa_raw[1][0] *= x;
-    gs->mtxa_raw[2][0] *= x;
-    gs->mtxa_raw[0][1] *= y;
-    gs->mtxa_raw[1][1] *= y;
-    gs->mtxa_raw[2][1] *= y;
-    gs->mtxa_raw[0][2] *= z;
-    gs->mtxa_raw[1][2] *= z;
-    gs->mtxa_raw[2][2] *= z;
+    if (mtxa_defer(MTXA_OP_SCALE, 0, x, y, z)) return;
+    mtx_scale_xyz(gs->mtxa_raw, x, y, z);
 }
 
 void mtxa_tf_point(Vec3f *src, Vec3f *dst)
@@ -461,12 +2001,33 @@ void mtxa_tf_vec(Vec3f *src, Vec3f *dst)
 
 void mtxa_tf_point_xyz(f32 x, f32 y, f32 z, Vec3f *dst)
 {
-    evec_to_vec3f(emtx_from_mtxa() * Eigen::Vector3f(x, y, z), dst);
+    mtxa_flush();
+    f32 out_x, out_y, out_z;
+    TfPointKernel()(gs->mtxa_raw, x, y, z, out_x, out_y, out_z);
+    *dst = {out_x, out_y, out_z};
 }
 
 void mtxa_tf_vec_xyz(f32 x, f32 y, f32 z, Vec3f *dst)
 {
-    evec_to_vec3f(emtx_from_mtxa().linear() * Eigen::Vector3f(x, y, z), dst);
+    mtxa_flush();
+    f32 out_x, out_y, out_z;
+    TfVecKernel()(gs->mtxa_raw, x, y, z, out_x, out_y, out_z);
+    *dst = {out_x, out_y, out_z};
+}
+
+void mtxa_tf_points(Vec3f *src, Vec3f *dst, u32 count)
+{
+    // Local copy so the matrix stays in registers instead of being reloaded after every store to `dst`
+    Mtx mtx;
+    mtxa_to_mtx(&mtx);
+    tf_batch(mtx, src, dst, count, TfPointKernel());
+}
+
+void mtxa_tf_vecs(Vec3f *src, Vec3f *dst, u32 count)
+{
+    Mtx mtx;
+    mtxa_to_mtx(&mtx);
+    tf_batch(mtx, src, dst, count, TfVecKernel());
 }
 
 void mtxa_rigid_inv_tf_point(Vec3f *src, Vec3f *dst)
@@ -476,14 +2037,22 @@ void mtxa_rigid_inv_tf_point(Vec3f *src, Vec3f *dst)
 
 void mtxa_rigid_inv_tf_point_xyz(f32 x, f32 y, f32 z, Vec3f *dst)
 {
-    f32 mtxa_x = gs->mtxa_raw[0][3];
-    f32 mtxa_y = gs->mtxa_raw[1][3];
-    f32 mtxa_z = gs->mtxa_raw[2][3];
-    mtxa_rigid_inv_tf_vec_xyz(x - mtxa_x, y - mtxa_y, z - mtxa_z, dst);
+    mtxa_flush();
+    f32 out_x, out_y, out_z;
+    RigidInvTfPointKernel()(gs->mtxa_raw, x, y, z, out_x, out_y, out_z);
+    *dst = {out_x, out_y, out_z};
+}
+
+void mtxa_rigid_inv_tf_points(Vec3f *src, Vec3f *dst, u32 count)
+{
+    Mtx mtx;
+    mtxa_to_mtx(&mtx);
+    tf_batch(mtx, src, dst, count, RigidInvTfPointKernel());
 }
 
 void mtxa_rigid_inv_tf_tl(Vec3f *dst)
 {
+    mtxa_flush();
     f32 x = gs->mtxa_raw[0][3];
     f32 y = gs->mtxa_raw[1][3];
     f32 z = gs->mtxa_raw[2][3];
@@ -500,40 +2069,351 @@ void mtxa_rigid_inv_tf_vec(Vec3f *src, Vec3f *dst)
 
 void mtxa_rigid_inv_tf_vec_xyz(f32 x, f32 y, f32 z, Vec3f *dst)
 {
-    EigenMtx emtxa(emtx_from_mtxa());
-    Eigen::Vector3f evec(x, y, z);
-    evec = emtxa.linear().transpose() * evec;
-    evec_to_vec3f(evec, dst);
+    mtxa_flush();
+    f32 out_x, out_y, out_z;
+    RigidInvTfVecKernel()(gs->mtxa_raw, x, y, z, out_x, out_y, out_z);
+    *dst = {out_x, out_y, out_z};
+}
+
+void mtxa_rigid_inv_tf_vecs(Vec3f *src, Vec3f *dst, u32 count)
+{
+    Mtx mtx;
+    mtxa_to_mtx(&mtx);
+    tf_batch(mtx, src, dst, count, RigidInvTfVecKernel());
+}
+
+/*
+ * Apply `kernel` with matrix `mtx` to `count` Vec3fA's from `src`, writing the results to `dst`.
+ *
+ * With SSE, the batched Vec3fA overloads transform a whole vector per SIMD register instead.
+ */
+template <typename Kernel>
+inline void tf_aligned(Mtx &mtx, Vec3fA *src, Vec3fA *dst, u32 count, Kernel kernel)
+{
+    for (u32 i = 0; i < count; i++)
+    {
+        f32 x = src[i].x;
+        f32 y = src[i].y;
+        f32 z = src[i].z;
+        kernel(mtx, x, y, z, dst[i].x, dst[i].y, dst[i].z);
+    }
+}
+
+// Transposing Matrix A into columns costs more than it saves for a single vector
+void mtxa_tf_point(Vec3fA *src, Vec3fA *dst)
+{
+    mtxa_flush();
+    tf_aligned(gs->mtxa_raw, src, dst, 1, TfPointKernel());
+}
+
+void mtxa_tf_vec(Vec3fA *src, Vec3fA *dst)
+{
+    mtxa_flush();
+    tf_aligned(gs->mtxa_raw, src, dst, 1, TfVecKernel());
+}
+
+void mtxa_tf_points(Vec3fA *src, Vec3fA *dst, u32 count)
+{
+    mtxa_flush();
+#ifdef EIGEN_VECTORIZE_SSE
+    __m128 cols[4];
+    mtx_cols_load(gs->mtxa_raw, cols);
+    for (u32 i = 0; i < count; i++)
+    {
+        __m128 vec = vec_lanes_combine(cols, _mm_load_ps(&src[i].x));
+        _mm_store_ps(&dst[i].x, _mm_add_ps(vec, cols[3]));
+    }
+#else
+    tf_aligned(gs->mtxa_raw, src, dst, count, TfPointKernel());
+#endif
+}
+
+void mtxa_tf_vecs(Vec3fA *src, Vec3fA *dst, u32 count)
+{
+    mtxa_flush();
+#ifdef EIGEN_VECTORIZE_SSE
+    __m128 cols[4];
+    mtx_cols_load(gs->mtxa_raw, cols);
+    for (u32 i = 0; i < count; i++)
+    {
+        _mm_store_ps(&dst[i].x, vec_lanes_combine(cols, _mm_load_ps(&src[i].x)));
+    }
+#else
+    tf_aligned(gs->mtxa_raw, src, dst, count, TfVecKernel());
+#endif
+}
+
+void mtxa_rigid_inv_tf_point(Vec3fA *src, Vec3fA *dst)
+{
+    mtxa_flush();
+#ifdef EIGEN_VECTORIZE_SSE
+    // The rows of the square part are the columns of its inverse
+    Mtx &mtx = gs->mtxa_raw;
+    __m128 rows[3] = {_mm_load_ps(mtx[0]), _mm_load_ps(mtx[1]), _mm_load_ps(mtx[2])};
+    __m128 rel = _mm_sub_ps(_mm_load_ps(&src->x), _mm_setr_ps(mtx[0][3], mtx[1][3], mtx[2][3], 0.f));
+    _mm_store_ps(&dst->x, vec_lanes_combine(rows, rel));
+#else
+    tf_aligned(gs->mtxa_raw, src, dst, 1, RigidInvTfPointKernel());
+#endif
+}
+
+void mtxa_rigid_inv_tf_vec(Vec3fA *src, Vec3fA *dst)
+{
+    mtxa_flush();
+#ifdef EIGEN_VECTORIZE_SSE
+    Mtx &mtx = gs->mtxa_raw;
+    __m128 rows[3] = {_mm_load_ps(mtx[0]), _mm_load_ps(mtx[1]), _mm_load_ps(mtx[2])};
+    _mm_store_ps(&dst->x, vec_lanes_combine(rows, _mm_load_ps(&src->x)));
+#else
+    tf_aligned(gs->mtxa_raw, src, dst, 1, RigidInvTfVecKernel());
+#endif
 }
 
 void mtxa_rotate_x(s16 angle)
 {
-    emtx_to_mtxa(emtx_from_mtxa() * Eigen::AngleAxisf(s16_to_radians(angle), Eigen::Vector3f::UnitX()));
+    if (mtxa_defer(MTXA_OP_ROTATE_X, angle, 0.f, 0.f, 0.f)) return;
+    mtx_rotate_cols(gs->mtxa_raw, 1, 2, angle);
 }
 
 void mtxa_rotate_y(s16 angle)
 {
-    emtx_to_mtxa(emtx_from_mtxa() * Eigen::AngleAxisf(s16_to_radians(angle), Eigen::Vector3f::UnitY()));
+    if (mtxa_defer(MTXA_OP_ROTATE_Y, angle, 0.f, 0.f, 0.f)) return;
+    mtx_rotate_cols(gs->mtxa_raw, 2, 0, angle);
 }
 
 void mtxa_rotate_z(s16 angle)
 {
-    emtx_to_mtxa(emtx_from_mtxa() * Eigen::AngleAxisf(s16_to_radians(angle), Eigen::Vector3f::UnitZ()));
+    if (mtxa_defer(MTXA_OP_ROTATE_Z, angle, 0.f, 0.f, 0.f)) return;
+    mtx_rotate_cols(gs->mtxa_raw, 0, 1, angle);
+}
+
+void mtx44_from_perspective(Mtx44 *out_mtx, s16 fov_y, f32 aspect, f32 z_near, f32 z_far)
+{
+    f32 cot = 1.f / math_tan(fov_y / 2);
+    f32 inv_depth = 1.f / (z_far - z_near);
+
+    memset(out_mtx, 0, sizeof(Mtx44));
+    (*out_mtx)[0][0] = cot / aspect;
+    (*out_mtx)[1][1] = cot;
+    (*out_mtx)[2][2] = -z_near * inv_depth;
+    (*out_mtx)[2][3] = -(z_far * z_near) * inv_depth;
+    (*out_mtx)[3][2] = -1.f;
+}
+
+void mtx44_from_ortho(Mtx44 *out_mtx, f32 top, f32 bottom, f32 left, f32 right, f32 z_near, f32 z_far)
+{
+    f32 inv_width = 1.f / (right - left);
+    f32 inv_height = 1.f / (top - bottom);
+    f32 inv_depth = 1.f / (z_far - z_near);
+
+    memset(out_mtx, 0, sizeof(Mtx44));
+    (*out_mtx)[0][0] = 2.f * inv_width;
+    (*out_mtx)[0][3] = -(right + left) * inv_width;
+    (*out_mtx)[1][1] = 2.f * inv_height;
+    (*out_mtx)[1][3] = -(top + bottom) * inv_height;
+    (*out_mtx)[2][2] = -inv_depth;
+    (*out_mtx)[2][3] = -z_far * inv_depth;
+    (*out_mtx)[3][3] = 1.f;
+}
+
+void mtx44_mult_mtx(Mtx44 *mtx44, Mtx *mtx, Mtx44 *dst)
+{
+    Mtx44 result;
+    for (s32 row = 0; row < 4; row++)
+    {
+        for (s32 col = 0; col < 4; col++)
+        {
+            result[row][col] = (*mtx44)[row][0] * (*mtx)[0][col] + (*mtx44)[row][1] * (*mtx)[1][col] +
+                               (*mtx44)[row][2] * (*mtx)[2][col];
+        }
+        result[row][3] += (*mtx44)[row][3];
+    }
+    memcpy(dst, result, sizeof(Mtx44));
+}
+
+/*
+ * Project point (x, y, z) by `mtx` to `viewport`, also computing its clip flags.
+ *
+ * The flags are accumulated in f32 lanes so they can be computed with `lane_select()`. They're small integers, so the
+ * sums are exact.
+ */
+struct ProjectKernel
+{
+    template <typename T>
+    void operator()(const Mtx44 &mtx, const Viewport &viewport, const T &x, const T &y, const T &z, T &out_x,
+                    T &out_y, T &out_z, T &out_flags) const
+    {
+        T clip_x = mtx[0][0] * x + mtx[0][1] * y + mtx[0][2] * z + mtx[0][3];
+        T clip_y = mtx[1][0] * x + mtx[1][1] * y + mtx[1][2] * z + mtx[1][3];
+        T clip_z = mtx[2][0] * x + mtx[2][1] * y + mtx[2][2] * z + mtx[2][3];
+        T clip_w = mtx[3][0] * x + mtx[3][1] * y + mtx[3][2] * z + mtx[3][3];
+
+        T neg_w = -clip_w;
+        T zero = lane_splat<T>(0.f);
+        out_flags = lane_select(clip_x < neg_w, lane_splat<T>(CLIP_LEFT), zero) +
+                    lane_select(clip_x > clip_w, lane_splat<T>(CLIP_RIGHT), zero) +
+                    lane_select(clip_y < neg_w, lane_splat<T>(CLIP_BOTTOM), zero) +
+                    lane_select(clip_y > clip_w, lane_splat<T>(CLIP_TOP), zero) +
+                    lane_select(clip_z < neg_w, lane_splat<T>(CLIP_NEAR), zero) +
+                    lane_select(clip_z > zero, lane_splat<T>(CLIP_FAR), zero);
+
+        T inv_w = 1.f / clip_w;
+        out_x = viewport.left + (clip_x * inv_w + 1.f) * (0.5f * viewport.width);
+        out_y = viewport.top + (1.f - clip_y * inv_w) * (0.5f * viewport.height);
+        out_z = clip_z * inv_w;
+    }
+};
+
+u8 mtx44_project_point(Mtx44 *mtx44, Viewport *viewport, Vec3f *point, Vec3f *out_screen_point)
+{
+    f32 out_x, out_y, out_z, flags;
+    ProjectKernel()(*mtx44, *viewport, point->x, point->y, point->z, out_x, out_y, out_z, flags);
+    *out_screen_point = {out_x, out_y, out_z};
+    return (u8) flags;
+}
+
+void mtx44_project_points(Mtx44 *mtx44, Viewport *viewport, Vec3f *points, Vec3f *out_screen_points,
+                          u8 *out_clip_flags, u32 count)
+{
+    // Local copies so they stay in registers instead of being reloaded after every store to the outputs
+    Mtx44 mtx;
+    memcpy(mtx, mtx44, sizeof(Mtx44));
+    Viewport local_viewport = *viewport;
+
+    u32 i = 0;
+    for (; i + LANE_COUNT <= count; i += LANE_COUNT)
+    {
+        LaneArray x, y, z, out_x, out_y, out_z, flags;
+        vec3f_lanes_load(&points[i], x, y, z);
+        ProjectKernel()(mtx, local_viewport, x, y, z, out_x, out_y, out_z, flags);
+        vec3f_lanes_store(out_x, out_y, out_z, &out_screen_points[i]);
+        for (u32 lane = 0; lane < LANE_COUNT; lane++) out_clip_flags[i + lane] = (u8) flags[lane];
+    }
+
+    for (; i < count; i++)
+    {
+        out_clip_flags[i] = mtx44_project_point(&mtx, &local_viewport, &points[i], &out_screen_points[i]);
+    }
+}
+
+void mtx_from_trs(Mtx *out_mtx, Vec3f *translate, Vec3s *rot, Vec3f *scale, EulerOrder order)
+{
+    f32 sin_cos[3][2];
+    math_sin_cos_v(rot->x, sin_cos[0]);
+    math_sin_cos_v(rot->y, sin_cos[1]);
+    math_sin_cos_v(rot->z, sin_cos[2]);
+
+    Mtx &m = *out_mtx;
+    mtx_sq_from_euler(m, sin_cos, order);
+
+    for (s32 row = 0; row < 3; row++)
+    {
+        m[row][0] *= scale->x;
+        m[row][1] *= scale->y;
+        m[row][2] *= scale->z;
+    }
+    m[0][3] = translate->x;
+    m[1][3] = translate->y;
+    m[2][3] = translate->z;
+}
+
+void mtx_from_euler_batch(Vec3s *rots, Mtx *out_mtxs, u32 count, EulerOrder order)
+{
+    u32 i = 0;
+    for (; i + LANE_COUNT <= count; i += LANE_COUNT)
+    {
+        // Table lookups don't vectorize, but building the matrices from their results does
+        LaneArray sin_cos[3][2];
+        for (u32 lane = 0; lane < LANE_COUNT; lane++)
+        {
+            s16 angles[3] = {rots[i + lane].x, rots[i + lane].y, rots[i + lane].z};
+            for (s32 axis = 0; axis < 3; axis++)
+            {
+                f32 lane_sin_cos[2];
+                math_sin_cos_v(angles[axis], lane_sin_cos);
+                sin_cos[axis][0][lane] = lane_sin_cos[0];
+                sin_cos[axis][1][lane] = lane_sin_cos[1];
+            }
+        }
+
+        LaneArray sq[3][3];
+        mtx_sq_from_euler(sq, sin_cos, order);
+        mtx_sq_lanes_store(sq, &out_mtxs[i]);
+    }
+
+    for (; i < count; i++)
+    {
+        f32 sin_cos[3][2];
+        math_sin_cos_v(rots[i].x, sin_cos[0]);
+        math_sin_cos_v(rots[i].y, sin_cos[1]);
+        math_sin_cos_v(rots[i].z, sin_cos[2]);
+        mtx_sq_from_euler(out_mtxs[i], sin_cos, order);
+        out_mtxs[i][0][3] = 0.f;
+        out_mtxs[i][1][3] = 0.f;
+        out_mtxs[i][2][3] = 0.f;
+    }
+}
+
+void mtxa_from_trs(Vec3f *translate, Vec3s *rot, Vec3f *scale, EulerOrder order)
+{
+    mtxa_discard_pending();
+    mtx_from_trs(&gs->mtxa_raw, translate, rot, scale, order);
 }
 
 void mtxa_from_quat(Quat *quat)
 {
-    emtx_to_mtxa(EigenMtx(Eigen::Quaternionf((f32 *) quat)));
+    mtxa_discard_pending();
+    f32 rot[3][3];
+    MtxFromQuatKernel()(*quat, rot);
+    for (s32 row = 0; row < 3; row++)
+    {
+        gs->mtxa_raw[row][0] = rot[row][0];
+        gs->mtxa_raw[row][1] = rot[row][1];
+        gs->mtxa_raw[row][2] = rot[row][2];
+        gs->mtxa_raw[row][3] = 0.f;
+    }
+}
+
+void mtx_from_quat_batch(Quat *quats, Mtx *out_mtxs, u32 count)
+{
+    u32 i = 0;
+    for (; i + LANE_COUNT <= count; i += LANE_COUNT)
+    {
+        QuatLanes quat;
+        LaneArray rot[3][3];
+        quat_lanes_load(&quats[i], quat);
+        MtxFromQuatKernel()(quat, rot);
+        mtx_sq_lanes_store(rot, &out_mtxs[i]);
+    }
+
+    for (; i < count; i++)
+    {
+        f32 rot[3][3];
+        MtxFromQuatKernel()(quats[i], rot);
+        for (s32 row = 0; row < 3; row++)
+        {
+            out_mtxs[i][row][0] = rot[row][0];
+            out_mtxs[i][row][1] = rot[row][1];
+            out_mtxs[i][row][2] = rot[row][2];
+            out_mtxs[i][row][3] = 0.f;
+        }
+    }
 }
 
 void quat_mult(Quat *dst, Quat *left, Quat *right)
 {
-    equat_to_quat(equat_from_quat(left) * equat_from_quat(right), dst);
+    QuatMultKernel()(*left, *right, *dst);
+}
+
+void quat_mult_batch(Quat *dst, Quat *left, Quat *right, u32 count)
+{
+    quat_batch(dst, left, right, count, QuatMultKernel());
 }
 
 void mtxa_to_quat(Quat *out_quat)
 {
-    equat_to_quat(Eigen::Quaternionf(emtx_from_mtxa().rotation()), out_quat);
+    mtxa_flush();
+    equat_to_quat(Eigen::Quaternionf(EigenMtx(emap_mtxa()).rotation()), out_quat);
 }
 
 void quat_from_axis_angle(Quat *out_quat, Vec3f *axis, s16 angle)
@@ -561,23 +2441,64 @@ double quat_to_axis_angle(Quat *quat, Vec3f *out_axis)
 
 void quat_normalize(Quat *quat)
 {
-    equat_to_quat(equat_from_quat(quat).normalized(), quat);
+    QuatNormalizeKernel()(*quat, *quat);
+}
+
+void quat_normalize_batch(Quat *quats, u32 count)
+{
+    quat_batch(quats, quats, count, QuatNormalizeKernel());
 }
 
 void quat_from_dirs(Quat *out_quat, Vec3f *start, Vec3f *end)
 {
-    Eigen::Vector3f estart((f32 *) start);
-    Eigen::Vector3f eend((f32 *) end);
-    Eigen::Quaternionf q(Eigen::Quaternionf::FromTwoVectors(estart, eend));
-    equat_to_quat(q, out_quat);
+    // Shortest-arc rotation: the half-way quaternion (|start||end| + start.end, start x end), normalized. Using the
+    // length product instead of assuming unit vectors makes the result independent of the inputs' lengths
+    f32 len_prod = sqrtf(VEC_LEN_SQ(*start) * VEC_LEN_SQ(*end));
+    if (len_prod == 0.f)
+    {
+        *out_quat = {0.f, 0.f, 0.f, 1.f};
+        return;
+    }
+
+    f32 w = len_prod + VEC_DOT(*start, *end);
+    Vec3f axis;
+    if (w <= 1e-6f * len_prod)
+    {
+        // Directions are (nearly) opposite, so any axis orthogonal to `start` gives a shortest-arc 180 degree rotation
+        w = 0.f;
+        if (fabsf(start->x) > fabsf(start->z)) axis = {-start->y, start->x, 0.f};
+        else axis = {0.f, -start->z, start->y};
+    }
+    else
+    {
+        axis = {start->y * end->z - start->z * end->y,
+                start->z * end->x - start->x * end->z,
+                start->x * end->y - start->y * end->x};
+    }
+
+    f32 inv_len = 1.f / sqrtf(VEC_LEN_SQ(axis) + w * w);
+    *out_quat = {axis.x * inv_len, axis.y * inv_len, axis.z * inv_len, w * inv_len};
 }
 
 void quat_slerp(f32 t, Quat *dst, Quat *quat1, Quat *quat2)
 {
-    Eigen::Quaternionf q1(equat_from_quat(quat1));
-    Eigen::Quaternionf q2(equat_from_quat(quat2));
-    Eigen::Quaternionf result = q1.slerp(t, q2);
-    equat_to_quat(result, dst);
+    QuatSlerpKernel()(t, *quat1, *quat2, *dst);
+}
+
+void quat_nlerp(f32 t, Quat *dst, Quat *quat1, Quat *quat2)
+{
+    QuatNlerpKernel()(t, *quat1, *quat2, *dst);
+}
+
+void quat_slerp_batch(f32 t, Quat *dst, Quat *quat1, Quat *quat2, u32 count, SlerpMode mode)
+{
+    // Bind `t` so the kernels fit `quat_batch()`
+    auto bind_t = [t](auto kernel) {
+        return [t, kernel](const auto &q1, const auto &q2, auto &out) { kernel(t, q1, q2, out); };
+    };
+
+    if (mode == SLERP_FAST) quat_batch(dst, quat1, quat2, count, bind_t(QuatNlerpKernel()));
+    else quat_batch(dst, quat1, quat2, count, bind_t(QuatSlerpKernel()));
 }
 
 void ray_to_euler(Vec3f *ray_start, Vec3f *ray_end, Vec3s *out_rot)
@@ -608,29 +2529,50 @@ void vec_to_euler_xy(Vec3f *vec, s16 *out_rot_x, s16 *out_rot_y)
     *out_rot_y = math_atan2(-vec->x, -vec->z);
 }
 
-void mtxa_to_euler_yxz(s16 *out_rot_y, s16 *out_rot_x, s16 *out_rot_z)
-{
-    mtxa_push();
-
-    Vec3f forward = {0.f, 0.f, -1.f};
-    Vec3f up = {0.f, 1.f, 0.f};
-    mtxa_tf_vec(&forward, &forward);
-    mtxa_tf_vec(&up, &up);
-
-    f32 forward_len2d = math_sqrt(forward.x * forward.x + forward.z * forward.z);
-    *out_rot_x = math_atan2(forward.y, forward_len2d);
+/*
+ * Extract y, x, z Euler angles from the square part of `m` in closed form.
+ *
+ * The original game transforms a forward and an up vector by the matrix, then undoes the Y and X rotations on the
+ * up vector by building a Y/X rotation matrix and inverse-transforming by it. Here the same arithmetic is written out
+ * directly on the known matrix entries. The terms with a zero factor are kept so that the signs of zero results, and
+ * therefore the quadrant chosen by `math_atan2()`, are identical as well.
+ */
+static inline void mtx_to_euler_yxz(const Mtx &m, s16 &out_rot_y, s16 &out_rot_x, s16 &out_rot_z)
+{
+    // Forward (0, 0, -1) and up (0, 1, 0) transformed by `m`
+    f32 forward_x = m[0][0] * 0.f + m[0][1] * 0.f + m[0][2] * -1.f;
+    f32 forward_y = m[1][0] * 0.f + m[1][1] * 0.f + m[1][2] * -1.f;
+    f32 forward_z = m[2][0] * 0.f + m[2][1] * 0.f + m[2][2] * -1.f;
+    f32 up_x = m[0][0] * 0.f + m[0][1] * 1.f + m[0][2] * 0.f;
+    f32 up_y = m[1][0] * 0.f + m[1][1] * 1.f + m[1][2] * 0.f;
+    f32 up_z = m[2][0] * 0.f + m[2][1] * 1.f + m[2][2] * 0.f;
+
+    f32 forward_len2d = math_sqrt(forward_x * forward_x + forward_z * forward_z);
+    out_rot_x = math_atan2(forward_y, forward_len2d);
     // Quick hack to add 180 degrees to the angle?
     // Appears this was achieved in original source's `math_vec_to_euler_xy()` by
     // negating both arguments to `math_atan2()`
-    *out_rot_y = math_atan2(forward.x, forward.z) + 0x8000;
-
-    // I think this undoes this X and Y rotation on the up vector, leaving only the Z rotation
-    mtxa_from_rotate_y(*out_rot_y);
-    mtxa_rotate_x(*out_rot_x);
-    mtxa_rigid_inv_tf_vec(&up, &up);
-    *out_rot_z = -math_atan2(up.x, up.y);
+    out_rot_y = math_atan2(forward_x, forward_z) + 0x8000;
+
+    // Undo the Y and X rotations on the up vector, leaving only the Z rotation. The first two columns of
+    // rotate_y(rot_y) * rotate_x(rot_x) are (cos_y, 0, -sin_y) and (sin_x * sin_y, cos_x, sin_x * cos_y)
+    f32 sin_cos_y[2], sin_cos_x[2];
+    math_sin_cos_v(out_rot_y, sin_cos_y);
+    math_sin_cos_v(out_rot_x, sin_cos_x);
+    f32 sin_y = sin_cos_y[0], cos_y = sin_cos_y[1];
+    f32 sin_x = sin_cos_x[0], cos_x = sin_cos_x[1];
+    f32 col1_x = cos_x * 0.f + sin_x * sin_y;
+    f32 col1_y = cos_x * 1.f + sin_x * 0.f;
+    f32 col1_z = cos_x * 0.f + sin_x * cos_y;
+    f32 local_up_x = cos_y * up_x + 0.f * up_y + -sin_y * up_z;
+    f32 local_up_y = col1_x * up_x + col1_y * up_y + col1_z * up_z;
+    out_rot_z = -math_atan2(local_up_x, local_up_y);
+}
 
-    mtxa_pop();
+void mtxa_to_euler_yxz(s16 *out_rot_y, s16 *out_rot_x, s16 *out_rot_z)
+{
+    mtxa_flush();
+    mtx_to_euler_yxz(gs->mtxa_raw, *out_rot_y, *out_rot_x, *out_rot_z);
 }
 
 void mtxa_to_euler(Vec3s *out_rot)
@@ -639,4 +2581,12 @@ void mtxa_to_euler(Vec3s *out_rot)
     mtxa_to_euler_yxz(&out_rot->y, &out_rot->x, &out_rot->z);
 }
 
+void mtx_to_euler_batch(Mtx *mtxs, Vec3s *out_rots, u32 count)
+{
+    for (u32 i = 0; i < count; i++)
+    {
+        mtx_to_euler_yxz(mtxs[i], out_rots[i].y, out_rots[i].x, out_rots[i].z);
+    }
+}
+
 }
\ No newline at end of file
@@ -1,73 +1,174 @@
 #include "pool.h"
 
+#include <cassert>
+
 #include "global_state.h"
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 namespace mkb2
 {
 
 void pool_init()
 {
-    gs->ball_pool_info.len = MAX_BALLS;
-    gs->ball_pool_info.status_list = gs->ball_status_list;
+    PoolCapacities capacities = gs->get_pool_capacities();
+    assert(pool_arena_size(&capacities) <= gs->get_pool_arena_size());
+
+    u8 *arena = (u8 *) gs.get() + sizeof(GlobalState);
+    u8 *arena_end = arena + gs->get_pool_arena_size();
+    gs->ball_pool.init(capacities.balls, &arena, arena_end);
+    gs->item_pool.init(capacities.items, &arena, arena_end);
+    gs->stobj_pool.init(capacities.stobjs, &arena, arena_end);
+    gs->sprite_pool.init(capacities.sprites, &arena, arena_end);
+    gs->effect_pool.init(capacities.effects, &arena, arena_end);
+    gs->camera_pool.init(capacities.cameras, &arena, arena_end);
+}
 
-    gs->item_pool_info.len = MAX_ITEMS;
-    gs->item_pool_info.status_list = gs->item_status_list;
+u32 pool_arena_size(PoolCapacities *capacities)
+{
+    return decltype(GlobalState::ball_pool)::arena_size(capacities->balls) +
+           decltype(GlobalState::item_pool)::arena_size(capacities->items) +
+           decltype(GlobalState::stobj_pool)::arena_size(capacities->stobjs) +
+           decltype(GlobalState::sprite_pool)::arena_size(capacities->sprites) +
+           decltype(GlobalState::effect_pool)::arena_size(capacities->effects) +
+           decltype(GlobalState::camera_pool)::arena_size(capacities->cameras);
+}
 
-    gs->stobj_pool_info.len = MAX_STOBJS;
-    gs->stobj_pool_info.status_list = gs->stobj_status_list;
+/*
+ * Index of the highest set bit of `bits`, which must be nonzero.
+ */
+static inline u32 bitmap_highest_bit(uint64_t bits)
+{
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanReverse64(&idx, bits);
+    return idx;
+#else
+    return 63 - __builtin_clzll(bits);
+#endif
+}
 
-    gs->sprite_pool_info.len = MAX_SPRITES;
-    gs->sprite_pool_info.status_list = gs->sprite_status_list;
+/*
+ * The lowest free slot of `info` at or after `idx`, or `len` if there are none.
+ */
+static u32 pool_find_free(PoolInfo *info, u32 idx)
+{
+    if (idx >= info->len) return info->len;
 
-    gs->effect_pool_info.len = MAX_EFFECTS;
-    gs->effect_pool_info.status_list = gs->effect_status_list;
+    uint64_t free_bits = info->free_bitmap[idx / 64] & (~(uint64_t) 0 << (idx % 64));
+    for (u32 word = idx / 64;;)
+    {
+        if (free_bits != 0) return word * 64 + bitmap_ctz(free_bits);
+        if (++word == pool_bitmap_len(info->len)) return info->len;
+        free_bits = info->free_bitmap[word];
+    }
+}
 
-    gs->camera_pool_info.len = MAX_CAMERAS;
-    gs->camera_pool_info.status_list = gs->camera_status_list;
+/*
+ * One past the highest live slot of `info` before `end`, or 0 if there are none.
+ */
+static u32 pool_find_live_end(PoolInfo *info, u32 end)
+{
+    if (end == 0) return 0;
 
-    pool_clear(&gs->ball_pool_info);
-    pool_clear(&gs->item_pool_info);
-    pool_clear(&gs->stobj_pool_info);
-    pool_clear(&gs->sprite_pool_info);
-    pool_clear(&gs->effect_pool_info);
-    pool_clear(&gs->camera_pool_info);
+    u32 word = (end - 1) / 64;
+    uint64_t live_bits = ~info->free_bitmap[word] & (~(uint64_t) 0 >> (63 - (end - 1) % 64));
+    for (;;)
+    {
+        if (live_bits != 0) return word * 64 + bitmap_highest_bit(live_bits) + 1;
+        if (word-- == 0) return 0;
+        live_bits = ~info->free_bitmap[word];
+    }
 }
 
-static void pool_update_idxs(PoolInfo *info, s32 event_id_filter)
+#ifndef NDEBUG
+
+// Only used to verify the pool metadata in debug builds
+
+/*
+ * Word `word` of the free bitmap of `info`, computed from its status list.
+ */
+static uint64_t pool_scan_free_bits(PoolInfo *info, u32 word)
+{
+    u32 end = word * 64 + 64 < info->len ? word * 64 + 64 : info->len;
+    uint64_t free_bits = 0;
+    for (u32 i = word * 64; i < end; i++)
+    {
+        free_bits |= (uint64_t) (info->status_list[i] == 0) << (i % 64);
+    }
+    return free_bits;
+}
+
+/*
+ * Compute the lowest free index and the upper bound of the live objects of `info` by scanning its whole status list,
+ * like the original game does every frame.
+ */
+static void pool_scan_idxs(PoolInfo *info, u32 *out_low_free_idx, u32 *out_upper_bound)
 {
     s32 new_low_free_idx = -1;
     u32 new_upper_bound = 0;
 
-    if (event_id_filter == EVENT_NONE || gs->events[event_id_filter].status != STAT_NULL)
+    for (u32 i = 0; i < info->len; i++)
     {
-        for (u32 i = 0; i < info->len; i++)
+        if (info->status_list[i] == 0)
+        {
+            if (new_low_free_idx == -1) new_low_free_idx = i;
+        }
+        else
         {
-            if (info->status_list[i] == 0)
-            {
-                if (new_low_free_idx == -1) new_low_free_idx = i;
-            }
-            else
-            {
-                new_upper_bound = i + 1;
-            }
+            new_upper_bound = i + 1;
         }
     }
 
     // If there's no free slots, just assume the first slot is free?
     if (new_low_free_idx == -1) new_low_free_idx = 0;
 
+    *out_low_free_idx = new_low_free_idx;
+    *out_upper_bound = new_upper_bound;
+}
+
+#endif
+
+static void pool_update_idxs(PoolInfo *info, s32 event_id_filter)
+{
+    u32 new_low_free_idx = 0;
+    u32 new_upper_bound = 0;
+
+#ifndef NDEBUG
+    // Every status change is supposed to go through the pool functions which keep the free bitmap, lowest free slot,
+    // and live end up to date. Verify that by rescanning the status list like the original game
+    for (u32 word = 0; word < pool_bitmap_len(info->len); word++)
+    {
+        assert(info->free_bitmap[word] == pool_scan_free_bits(info, word));
+    }
+    u32 scanned_low_free_idx, scanned_upper_bound;
+    pool_scan_idxs(info, &scanned_low_free_idx, &scanned_upper_bound);
+    assert(info->lowest_free == pool_find_free(info, 0));
+    assert((info->lowest_free == info->len ? 0 : info->lowest_free) == scanned_low_free_idx);
+    assert(info->live_end == scanned_upper_bound);
+#endif
+
+    if (event_id_filter == EVENT_NONE || gs->events[event_id_filter].status != STAT_NULL)
+    {
+        // Like the original game, a full pool reports slot 0 as its lowest free slot
+        new_low_free_idx = info->lowest_free == info->len ? 0 : info->lowest_free;
+        new_upper_bound = info->live_end;
+    }
+
     info->low_free_idx = new_low_free_idx;
     info->upper_bound = new_upper_bound;
 }
 
 static void pool_update_idxs_of_all_pools()
 {
-    pool_update_idxs(&gs->ball_pool_info, EVENT_NONE);
-    pool_update_idxs(&gs->item_pool_info, EVENT_ITEM);
-    pool_update_idxs(&gs->stobj_pool_info, EVENT_STOBJ);
-    pool_update_idxs(&gs->sprite_pool_info, EVENT_SPRITE);
-    pool_update_idxs(&gs->effect_pool_info, EVENT_EFFECT);
-    pool_update_idxs(&gs->camera_pool_info, EVENT_CAMERA);
+    pool_update_idxs(gs->ball_pool.info(), EVENT_NONE);
+    pool_update_idxs(gs->item_pool.info(), EVENT_ITEM);
+    pool_update_idxs(gs->stobj_pool.info(), EVENT_STOBJ);
+    pool_update_idxs(gs->sprite_pool.info(), EVENT_SPRITE);
+    pool_update_idxs(gs->effect_pool.info(), EVENT_EFFECT);
+    pool_update_idxs(gs->camera_pool.info(), EVENT_CAMERA);
 }
 
 void pool_tick()
@@ -78,45 +179,60 @@ void pool_tick()
 
 s32 pool_alloc(PoolInfo *info, u8 status)
 {
-    // Search for a free idx starting at the "low free idx" (last known lowest free idx)
-    // until the end of the list is reached
-    for (u32 i = 0; i < info->len; i++)
-    {
-        if (info->status_list[i] == 0)
-        {
-            if (info->upper_bound < i + 1) info->upper_bound = i + 1;
-            info->low_free_idx = i + 1;
+    // The original game searches the status list one slot at a time for the lowest free slot, which is kept up to date
+    // here instead
+    u32 i = info->lowest_free;
+    if (i == info->len) return -1;
 
-            info->status_list[i] = status;
-            return i;
-        }
-    }
+    if (info->upper_bound < i + 1) info->upper_bound = i + 1;
+    info->low_free_idx = i + 1;
 
-    // If no free slot was found after `low_free_idx`, look for a free slot from the beginning of the list
-    // (this would happen if something below `low_free_idx` was freed this frame)
-    for (u32 i = 0; i < info->low_free_idx; i++)
+    // A status of 0 leaves the slot free
+    pool_set_status(info, i, status);
+    return i;
+}
+
+void pool_free(PoolInfo *info, u32 idx)
+{
+    pool_set_status(info, idx, 0);
+}
+
+void pool_set_status(PoolInfo *info, u32 idx, u8 status)
+{
+    ((u8 *) info->status_list)[idx] = status;
+
+    uint64_t bit = (uint64_t) 1 << (idx % 64);
+    bool was_free = (info->free_bitmap[idx / 64] & bit) != 0;
+    if (status == 0 && !was_free)
     {
-        if (info->status_list[i] == 0)
-        {
-            info->low_free_idx = i + 1;
-            info->status_list[i] = status;
-            return i;
-        }
+        info->free_bitmap[idx / 64] |= bit;
+        if (idx < info->lowest_free) info->lowest_free = idx;
+        if (idx + 1 == info->live_end) info->live_end = pool_find_live_end(info, idx);
+    }
+    else if (status != 0 && was_free)
+    {
+        info->free_bitmap[idx / 64] &= ~bit;
+        if (idx == info->lowest_free) info->lowest_free = pool_find_free(info, idx + 1);
+        if (idx + 1 > info->live_end) info->live_end = idx + 1;
     }
-
-    // No free slot was found
-    return -1;
 }
 
 void pool_clear(PoolInfo *info)
 {
     for (u32 i = 0; i < info->len; i++)
     {
-        info->status_list[i] = 0;
+        ((u8 *) info->status_list)[i] = 0;
     }
 
     info->low_free_idx = 0;
     info->upper_bound = 0;
+    info->lowest_free = 0;
+    info->live_end = 0;
+
+    for (u32 word = 0; word < pool_bitmap_len(info->len); word++)
+    {
+        info->free_bitmap[word] = bitmap_slot_mask(info->len, word);
+    }
 }
 
 }
\ No newline at end of file
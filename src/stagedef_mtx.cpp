@@ -0,0 +1,47 @@
+#include "stagedef_mtx.h"
+
+#include "mathutil.h"
+#include "stagedef.h"
+
+namespace mkb2
+{
+
+u32 stagedef_coli_header_child_count(StagedefCollisionHeader *coli_header)
+{
+    return coli_header->bumper_count + coli_header->jamabar_count + coli_header->banana_count +
+           coli_header->cone_collision_object_count + coli_header->stage_model_instance_count;
+}
+
+u32 stagedef_coli_header_to_world_mtxs(StagedefCollisionHeader *coli_header, Mtx *coli_header_mtx, Mtx *out_mtxs)
+{
+    Mtx *mtx = out_mtxs;
+
+    // Local transforms first
+    mtx_from_trs_batch(coli_header->bumper_list, mtx, coli_header->bumper_count, EULER_ORDER_ZYX);
+    mtx += coli_header->bumper_count;
+    mtx_from_trs_batch(coli_header->jamabar_list, mtx, coli_header->jamabar_count, EULER_ORDER_ZYX);
+    mtx += coli_header->jamabar_count;
+    for (u32 i = 0; i < coli_header->banana_count; i++, mtx++)
+    {
+        for (s32 row = 0; row < 3; row++)
+        {
+            for (s32 col = 0; col < 3; col++) (*mtx)[row][col] = row == col ? 1.f : 0.f;
+        }
+        (*mtx)[0][3] = coli_header->banana_list[i].position.x;
+        (*mtx)[1][3] = coli_header->banana_list[i].position.y;
+        (*mtx)[2][3] = coli_header->banana_list[i].position.z;
+    }
+    mtx_from_trs_batch(coli_header->cone_collision_object_list, mtx, coli_header->cone_collision_object_count,
+                       EULER_ORDER_ZYX);
+    mtx += coli_header->cone_collision_object_count;
+    mtx_from_trs_batch(coli_header->stage_model_instance_list, mtx, coli_header->stage_model_instance_count,
+                       EULER_ORDER_ZYX);
+    mtx += coli_header->stage_model_instance_count;
+
+    // Then concatenate them all with the collision header's transform in one pass
+    u32 count = mtx - out_mtxs;
+    mtx_mult_batch(coli_header_mtx, out_mtxs, out_mtxs, count);
+    return count;
+}
+
+}
\ No newline at end of file
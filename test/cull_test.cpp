@@ -0,0 +1,228 @@
+#include <catch.hpp>
+
+#include "cull.h"
+#include "mathutil.h"
+#include "global_state.h"
+#include "stagedef.h"
+#include "test_rand.h"
+
+using namespace mkb2;
+
+/*
+ * Camera at (0, 0, 10) looking down -Z with a 90 degree vertical FOV and a square viewport.
+ */
+static void make_test_frustum(Frustum *out_frustum)
+{
+    Mtx44 proj;
+    mtx44_from_perspective(&proj, 0x4000, 1.f, 1.f, 100.f);
+    Mtx view = {{1.f, 0.f, 0.f, 0.f}, {0.f, 1.f, 0.f, 0.f}, {0.f, 0.f, 1.f, -10.f}};
+    frustum_from_camera(out_frustum, &proj, &view);
+}
+
+TEST_CASE("frustum_from_camera()", "[cull]")
+{
+    Frustum frustum;
+    make_test_frustum(&frustum);
+
+    // Planes of the 90 degree FOV pass through the camera at 45 degrees
+    f32 diag = 1.f / sqrtf(2.f);
+    CHECK(frustum.planes[0].normal.x == Approx(diag));
+    CHECK(frustum.planes[0].normal.z == Approx(-diag));
+    CHECK(frustum.planes[0].dist == Approx(10.f * diag));
+    CHECK(frustum.planes[3].normal.y == Approx(-diag));
+
+    // Near and far planes are 1 and 100 units in front of the camera
+    CHECK(frustum.planes[4].normal.z == Approx(-1.f));
+    CHECK(frustum.planes[4].dist == Approx(9.f));
+    CHECK(frustum.planes[5].normal.z == Approx(1.f));
+    CHECK(frustum.planes[5].dist == Approx(90.f));
+}
+
+TEST_CASE("cull_spheres() and cull_aabbs()", "[cull]")
+{
+    Frustum frustum;
+    make_test_frustum(&frustum);
+
+    SECTION("individual volumes")
+    {
+        Sphere spheres[] = {
+            {{0.f, 0.f, 0.f}, 1.f},     // Inside
+            {{20.f, 0.f, 0.f}, 1.f},    // Right of the frustum
+            {{10.5f, 0.f, 0.f}, 1.f},   // Straddling the right plane
+            {{0.f, 0.f, 20.f}, 5.f},    // Behind the camera
+            {{0.f, 0.f, 9.5f}, 1.f},    // Straddling the near plane
+            {{0.f, 0.f, -90.f}, 2.f},   // Straddling the far plane
+            {{0.f, 0.f, -100.f}, 2.f},  // Beyond the far plane
+            {{0.f, -40.f, -20.f}, 5.f}, // Below
+        };
+        u32 idxs[8];
+        REQUIRE(cull_spheres(&frustum, spheres, 8, idxs) == 4);
+        CHECK(idxs[0] == 0);
+        CHECK(idxs[1] == 2);
+        CHECK(idxs[2] == 4);
+        CHECK(idxs[3] == 5);
+
+        Aabb aabbs[] = {
+            {{-1.f, -1.f, -1.f}, {1.f, 1.f, 1.f}},        // Inside
+            {{19.f, -1.f, -1.f}, {21.f, 1.f, 1.f}},       // Right of the frustum
+            {{10.f, -1.f, -1.f}, {30.f, 1.f, 1.f}},       // Straddling the right plane
+            {{-100.f, -1.f, 11.f}, {100.f, 1.f, 12.f}},   // Behind the camera
+            {{-100.f, 70.f, -50.f}, {100.f, 80.f, 0.f}},  // Above
+            {{-1.f, -1.f, -200.f}, {1.f, 1.f, 200.f}},    // Through the whole frustum
+        };
+        REQUIRE(cull_aabbs(&frustum, aabbs, 6, idxs) == 3);
+        CHECK(idxs[0] == 0);
+        CHECK(idxs[1] == 2);
+        CHECK(idxs[2] == 5);
+    }
+
+    SECTION("SIMD groups match one at a time")
+    {
+        // Odd count to cover the non-SIMD remainder
+        constexpr u32 COUNT = 103;
+        Sphere spheres[COUNT];
+        Aabb aabbs[COUNT];
+        u32 state = 0x1234567;
+        for (u32 i = 0; i < COUNT; i++)
+        {
+            Vec3f center = {test_rand_f32(state, 60.f), test_rand_f32(state, 60.f), test_rand_f32(state, 60.f)};
+            f32 size = test_rand_f32(state, 5.f) + 5.f;
+            spheres[i] = {center, size};
+            aabbs[i] = {{center.x - size, center.y - size * 0.5f, center.z - size * 2.f},
+                        {center.x + size, center.y + size * 0.5f, center.z + size * 2.f}};
+        }
+        spheres[5].center.x = NAN;
+
+        u32 idxs[COUNT], single_idxs[COUNT];
+        u32 visible_count = cull_spheres(&frustum, spheres, COUNT, idxs);
+        u32 single_count = 0;
+        for (u32 i = 0; i < COUNT; i++)
+        {
+            u32 idx;
+            if (cull_spheres(&frustum, &spheres[i], 1, &idx) == 1) single_idxs[single_count++] = i;
+        }
+        CHECK(visible_count > 0);
+        CHECK(visible_count < COUNT);
+        REQUIRE(visible_count == single_count);
+        REQUIRE(memcmp(idxs, single_idxs, visible_count * sizeof(u32)) == 0);
+
+        visible_count = cull_aabbs(&frustum, aabbs, COUNT, idxs);
+        single_count = 0;
+        for (u32 i = 0; i < COUNT; i++)
+        {
+            u32 idx;
+            if (cull_aabbs(&frustum, &aabbs[i], 1, &idx) == 1) single_idxs[single_count++] = i;
+        }
+        CHECK(visible_count > 0);
+        CHECK(visible_count < COUNT);
+        REQUIRE(visible_count == single_count);
+        REQUIRE(memcmp(idxs, single_idxs, visible_count * sizeof(u32)) == 0);
+    }
+}
+
+TEST_CASE("stagedef bounding spheres", "[cull]")
+{
+    Mtx coli_header_mtx;
+    mtxa_from_translate_xyz(0.f, 5.f, 0.f);
+    mtxa_rotate_y(0x4000);
+    mtxa_to_mtx(&coli_header_mtx);
+
+    SECTION("bananas")
+    {
+        StagedefBanana bananas[2] = {};
+        bananas[0].position = {1.f, 2.f, 3.f};
+        bananas[1].position = {-4.f, 0.f, 0.f};
+        Sphere spheres[2];
+
+        stagedef_banana_spheres(bananas, 2, nullptr, spheres);
+        CHECK(spheres[0].center.x == 1.f);
+        CHECK(spheres[0].center.y == 2.f);
+        CHECK(spheres[0].center.z == 3.f);
+        CHECK(spheres[0].radius == BANANA_CULL_RADIUS);
+
+        stagedef_banana_spheres(bananas, 2, &coli_header_mtx, spheres);
+        CHECK(spheres[1].center.x == Approx(0.f).margin(1e-5));
+        CHECK(spheres[1].center.y == Approx(5.f));
+        CHECK(spheres[1].center.z == Approx(4.f));
+        CHECK(spheres[1].radius == Approx(BANANA_CULL_RADIUS));
+    }
+
+    SECTION("stage model instances")
+    {
+        // More instances than are processed in one chunk
+        constexpr u32 COUNT = 150;
+        static StagedefStageModelInstance instances[COUNT] = {};
+        static Sphere model_bounds[COUNT], spheres[COUNT];
+        for (u32 i = 0; i < COUNT; i++)
+        {
+            instances[i].position = {(f32) i, 0.f, 0.f};
+            instances[i].rotation = {0, (s16) (i * 0x100), 0};
+            instances[i].scale = {1.f, 2.f + i, 1.f};
+            model_bounds[i] = {{0.f, 1.f, 0.f}, 0.5f};
+        }
+
+        stagedef_stage_model_instance_spheres(instances, COUNT, &coli_header_mtx, model_bounds, spheres);
+        for (u32 i = 0; i < COUNT; i++)
+        {
+            // The model's center is scaled up along Y, and the radius by the largest scale
+            CHECK(spheres[i].center.x == Approx(0.f).margin(1e-4));
+            CHECK(spheres[i].center.y == Approx(5.f + 2.f + i));
+            CHECK(spheres[i].center.z == Approx(-(f32) i).margin(1e-4));
+            CHECK(spheres[i].radius == Approx(0.5f * (2.f + i)));
+        }
+    }
+
+    SECTION("background models")
+    {
+        StagedefBackgroundModel models[1] = {};
+        models[0].position = {0.f, 0.f, -50.f};
+        models[0].rotation = {0, 0, 0x4000};
+        models[0].scale = {3.f, 1.f, 1.f};
+        Sphere model_bounds[1] = {{{1.f, 0.f, 0.f}, 2.f}};
+        Sphere spheres[1];
+
+        stagedef_background_model_spheres(models, 1, model_bounds, spheres);
+        CHECK(spheres[0].center.x == Approx(0.f).margin(1e-5));
+        CHECK(spheres[0].center.y == Approx(3.f));
+        CHECK(spheres[0].center.z == Approx(-50.f));
+        CHECK(spheres[0].radius == Approx(6.f));
+    }
+}
+
+TEST_CASE("frustum culling", "[cull][.][benchmark]")
+{
+    constexpr u32 COUNT = 4096;
+    static Sphere spheres[COUNT];
+    static Aabb aabbs[COUNT];
+    static u32 idxs[COUNT];
+    u32 state = 0x1234567;
+    for (u32 i = 0; i < COUNT; i++)
+    {
+        Vec3f center = {test_rand_f32(state, 200.f), test_rand_f32(state, 200.f), test_rand_f32(state, 200.f)};
+        spheres[i] = {center, 2.f};
+        aabbs[i] = {{center.x - 2.f, center.y - 2.f, center.z - 2.f}, {center.x + 2.f, center.y + 2.f, center.z + 2.f}};
+    }
+    Frustum frustum;
+    make_test_frustum(&frustum);
+
+    BENCHMARK("cull_spheres() one at a time")
+    {
+        u32 visible_count = 0;
+        for (u32 i = 0; i < COUNT; i++) visible_count += cull_spheres(&frustum, &spheres[i], 1, &idxs[visible_count]);
+        return visible_count;
+    };
+    BENCHMARK("cull_spheres()")
+    {
+        return cull_spheres(&frustum, spheres, COUNT, idxs);
+    };
+    BENCHMARK("cull_aabbs() one at a time")
+    {
+        u32 visible_count = 0;
+        for (u32 i = 0; i < COUNT; i++) visible_count += cull_aabbs(&frustum, &aabbs[i], 1, &idxs[visible_count]);
+        return visible_count;
+    };
+    BENCHMARK("cull_aabbs()")
+    {
+        return cull_aabbs(&frustum, aabbs, COUNT, idxs);
+    };
+}
\ No newline at end of file
@@ -0,0 +1,841 @@
+#include <catch.hpp>
+
+#include <Eigen/Dense>
+
+#include "mathutil.h"
+#include "mathpolicy.h"
+#include "global_state.h"
+#include "stagedef.h"
+
+using namespace mkb2;
+
+/*
+ * Math library benchmarks.
+ *
+ * These are hidden by default, run them with: `libmkb_test_run [benchmark]`
+ *
+ * Some benchmarks compare against a "legacy" implementation kept here, which reproduces a previous implementation
+ * of the same function so the difference can be measured on the same machine.
+ */
+
+using EigenMtx = Eigen::Transform<f32, 3, Eigen::AffineCompact, Eigen::RowMajor>;
+
+static void bench_load_mtxs()
+{
+    Vec3f axis = {-0.420523f, 0.84720234f, 0.286542f};
+    Quat quat;
+    quat_from_axis_angle(&quat, &axis, 0x3a41);
+    mtxa_from_quat(&quat);
+    mtxa_translate_xyz(25.34604f, -0.543234f, -43.0942f);
+    mtxa_to_mtxb();
+    mtxa_rotate_y(0x1234);
+}
+
+/*
+ * Legacy Mtx <-> Eigen conversions which memcpy the matrix into a temporary and back on every call.
+ */
+
+static EigenMtx legacy_emtx_from_mtx(Mtx *mtx)
+{
+    EigenMtx emtx;
+    memcpy(emtx.data(), mtx, sizeof(Mtx));
+    return emtx;
+}
+
+static void legacy_emtx_to_mtx(const EigenMtx &emtx, Mtx *mtx)
+{
+    memcpy(mtx, emtx.data(), sizeof(Mtx));
+}
+
+static void legacy_mtxa_mult_right(Mtx *mtx)
+{
+    legacy_emtx_to_mtx(legacy_emtx_from_mtx(&gs->mtxa_raw) * legacy_emtx_from_mtx(mtx), &gs->mtxa_raw);
+}
+
+static void legacy_mtxa_translate_xyz(f32 x, f32 y, f32 z)
+{
+    EigenMtx emtx(legacy_emtx_from_mtx(&gs->mtxa_raw));
+    emtx.translation() = emtx * Eigen::Vector3f(x, y, z);
+    legacy_emtx_to_mtx(emtx, &gs->mtxa_raw);
+}
+
+static void legacy_mtxa_tf_point_xyz(f32 x, f32 y, f32 z, Vec3f *dst)
+{
+    Eigen::Vector3f evec(legacy_emtx_from_mtx(&gs->mtxa_raw) * Eigen::Vector3f(x, y, z));
+    dst->x = evec.x();
+    dst->y = evec.y();
+    dst->z = evec.z();
+}
+
+static void legacy_mtxa_rigid_inv_tf_vec_xyz(f32 x, f32 y, f32 z, Vec3f *dst)
+{
+    Eigen::Vector3f evec(legacy_emtx_from_mtx(&gs->mtxa_raw).linear().transpose() * Eigen::Vector3f(x, y, z));
+    dst->x = evec.x();
+    dst->y = evec.y();
+    dst->z = evec.z();
+}
+
+static void legacy_mtxa_rotate_x(s16 angle)
+{
+    f32 angle_rad = angle * (f32) M_PI / 0x8000;
+    legacy_emtx_to_mtx(legacy_emtx_from_mtx(&gs->mtxa_raw) *
+                           Eigen::AngleAxisf(angle_rad, Eigen::Vector3f::UnitX()),
+                       &gs->mtxa_raw);
+}
+
+static void legacy_mtxa_from_rotate_x(s16 angle)
+{
+    f32 angle_rad = angle * (f32) M_PI / 0x8000;
+    legacy_emtx_to_mtx(EigenMtx(Eigen::AngleAxisf(angle_rad, Eigen::Vector3f::UnitX())), &gs->mtxa_raw);
+}
+
+TEST_CASE("mtxa Eigen views vs. copies", "[mathutil][.][benchmark]")
+{
+    bench_load_mtxs();
+    Mtx mtx;
+    mtxa_to_mtx(&mtx);
+    Vec3f vec = {1.5f, -2.25f, 3.125f};
+
+    BENCHMARK("mtxa_mult_right() legacy")
+    {
+        mtxa_from_mtxb();
+        legacy_mtxa_mult_right(&mtx);
+        return gs->mtxa_raw[0][0];
+    };
+    BENCHMARK("mtxa_mult_right()")
+    {
+        mtxa_from_mtxb();
+        mtxa_mult_right(&mtx);
+        return gs->mtxa_raw[0][0];
+    };
+
+    BENCHMARK("mtxa_translate_xyz() legacy")
+    {
+        mtxa_from_mtxb();
+        legacy_mtxa_translate_xyz(vec.x, vec.y, vec.z);
+        return gs->mtxa_raw[0][3];
+    };
+    BENCHMARK("mtxa_translate_xyz()")
+    {
+        mtxa_from_mtxb();
+        mtxa_translate_xyz(vec.x, vec.y, vec.z);
+        return gs->mtxa_raw[0][3];
+    };
+
+    BENCHMARK("mtxa_tf_point_xyz() legacy")
+    {
+        Vec3f dst;
+        legacy_mtxa_tf_point_xyz(vec.x, vec.y, vec.z, &dst);
+        return dst.x;
+    };
+    BENCHMARK("mtxa_tf_point_xyz()")
+    {
+        Vec3f dst;
+        mtxa_tf_point_xyz(vec.x, vec.y, vec.z, &dst);
+        return dst.x;
+    };
+
+    BENCHMARK("mtxa_rigid_inv_tf_vec_xyz() legacy")
+    {
+        Vec3f dst;
+        legacy_mtxa_rigid_inv_tf_vec_xyz(vec.x, vec.y, vec.z, &dst);
+        return dst.x;
+    };
+    BENCHMARK("mtxa_rigid_inv_tf_vec_xyz()")
+    {
+        Vec3f dst;
+        mtxa_rigid_inv_tf_vec_xyz(vec.x, vec.y, vec.z, &dst);
+        return dst.x;
+    };
+}
+
+TEST_CASE("s16 trig", "[mathutil][.][benchmark]")
+{
+    BENCHMARK("libm sin() and cos()")
+    {
+        f32 sum = 0.f;
+        for (s32 i = 0; i < 0x10000; i += 0x41)
+        {
+            f64 angle_rad = (s16) i * M_PI / 0x8000;
+            sum += (f32) sin(angle_rad) + (f32) cos(angle_rad);
+        }
+        return sum;
+    };
+    BENCHMARK("math_sin_cos_v()")
+    {
+        f32 sum = 0.f;
+        for (s32 i = 0; i < 0x10000; i += 0x41)
+        {
+            f32 sin_cos[2];
+            math_sin_cos_v(i, sin_cos);
+            sum += sin_cos[0] + sin_cos[1];
+        }
+        return sum;
+    };
+
+    bench_load_mtxs();
+    BENCHMARK("mtxa_rotate_x()")
+    {
+        mtxa_from_mtxb();
+        mtxa_rotate_x(0x1234);
+        return gs->mtxa_raw[0][0];
+    };
+}
+
+TEST_CASE("s16 atan2", "[mathutil][.][benchmark]")
+{
+    BENCHMARK("libm atan2()")
+    {
+        s32 sum = 0;
+        for (s32 i = -16; i < 16; i++)
+        {
+            for (s32 j = -16; j < 16; j++)
+            {
+                sum += (s16) (s32) (atan2(i * 0.37, j * 0.53) * 0x8000 / M_PI);
+            }
+        }
+        return sum;
+    };
+    BENCHMARK("math_atan2()")
+    {
+        s32 sum = 0;
+        for (s32 i = -16; i < 16; i++)
+        {
+            for (s32 j = -16; j < 16; j++)
+            {
+                sum += math_atan2(i * 0.37, j * 0.53);
+            }
+        }
+        return sum;
+    };
+}
+
+TEST_CASE("batched mtxa transforms", "[mathutil][.][benchmark]")
+{
+    constexpr u32 COUNT = 1024;
+    static Vec3f src[COUNT], dst[COUNT];
+    for (u32 i = 0; i < COUNT; i++) src[i] = {i * 0.25f, i * -0.5f, 3.f - i};
+    bench_load_mtxs();
+
+    BENCHMARK("mtxa_tf_point() loop")
+    {
+        for (u32 i = 0; i < COUNT; i++) mtxa_tf_point(&src[i], &dst[i]);
+        return dst[COUNT - 1].x;
+    };
+    BENCHMARK("mtxa_tf_points()")
+    {
+        mtxa_tf_points(src, dst, COUNT);
+        return dst[COUNT - 1].x;
+    };
+    BENCHMARK("mtxa_tf_vec() loop")
+    {
+        for (u32 i = 0; i < COUNT; i++) mtxa_tf_vec(&src[i], &dst[i]);
+        return dst[COUNT - 1].x;
+    };
+    BENCHMARK("mtxa_tf_vecs()")
+    {
+        mtxa_tf_vecs(src, dst, COUNT);
+        return dst[COUNT - 1].x;
+    };
+    BENCHMARK("mtxa_rigid_inv_tf_point() loop")
+    {
+        for (u32 i = 0; i < COUNT; i++) mtxa_rigid_inv_tf_point(&src[i], &dst[i]);
+        return dst[COUNT - 1].x;
+    };
+    BENCHMARK("mtxa_rigid_inv_tf_points()")
+    {
+        mtxa_rigid_inv_tf_points(src, dst, COUNT);
+        return dst[COUNT - 1].x;
+    };
+}
+
+TEST_CASE("mtxa inverses", "[mathutil][.][benchmark]")
+{
+    bench_load_mtxs();
+
+    BENCHMARK("Eigen Transform::inverse() legacy")
+    {
+        mtxa_from_mtxb();
+        EigenMtx emtx(legacy_emtx_from_mtx(&gs->mtxa_raw).inverse());
+        legacy_emtx_to_mtx(emtx, &gs->mtxa_raw);
+        return gs->mtxa_raw[0][0];
+    };
+    BENCHMARK("mtxa_invert()")
+    {
+        mtxa_from_mtxb();
+        mtxa_invert();
+        return gs->mtxa_raw[0][0];
+    };
+    BENCHMARK("mtxa_rigid_invert()")
+    {
+        mtxa_from_mtxb();
+        mtxa_rigid_invert();
+        return gs->mtxa_raw[0][0];
+    };
+    BENCHMARK("mtxa_uniform_scale_invert()")
+    {
+        mtxa_from_mtxb();
+        mtxa_uniform_scale_invert();
+        return gs->mtxa_raw[0][0];
+    };
+}
+
+TEST_CASE("mtxa single-axis rotations", "[mathutil][.][benchmark]")
+{
+    bench_load_mtxs();
+    s16 angle = 0x1234;
+
+    BENCHMARK("mtxa_rotate_x() legacy")
+    {
+        legacy_mtxa_rotate_x(angle += 0x111);
+        return gs->mtxa_raw[0][0];
+    };
+    BENCHMARK("mtxa_rotate_x()")
+    {
+        mtxa_rotate_x(angle += 0x111);
+        return gs->mtxa_raw[0][0];
+    };
+    BENCHMARK("mtxa_from_rotate_x() legacy")
+    {
+        legacy_mtxa_from_rotate_x(angle += 0x111);
+        return gs->mtxa_raw[1][1];
+    };
+    BENCHMARK("mtxa_from_rotate_x()")
+    {
+        mtxa_from_rotate_x(angle += 0x111);
+        return gs->mtxa_raw[1][1];
+    };
+}
+
+TEST_CASE("fused TRS transforms", "[mathutil][.][benchmark]")
+{
+    constexpr u32 COUNT = 256;
+    static StagedefBumper bumpers[COUNT];
+    static Mtx mtxs[COUNT];
+    for (u32 i = 0; i < COUNT; i++)
+    {
+        bumpers[i].position = {i * 1.5f, i * -0.25f, 3.f};
+        bumpers[i].rotation = {(s16) (i * 0x1357), (s16) (i * 0x0bcd), (s16) (i * 0x2222)};
+        bumpers[i].scale = {1.f, 2.f, 0.5f};
+    }
+
+    BENCHMARK("translate/rotate_z/rotate_y/rotate_x/scale chain")
+    {
+        for (u32 i = 0; i < COUNT; i++)
+        {
+            mtxa_from_translate(&bumpers[i].position);
+            mtxa_rotate_z(bumpers[i].rotation.z);
+            mtxa_rotate_y(bumpers[i].rotation.y);
+            mtxa_rotate_x(bumpers[i].rotation.x);
+            mtxa_scale(&bumpers[i].scale);
+            mtxa_to_mtx(&mtxs[i]);
+        }
+        return mtxs[COUNT - 1][0][0];
+    };
+    BENCHMARK("mtx_from_trs_batch()")
+    {
+        mtx_from_trs_batch(bumpers, mtxs, COUNT, EULER_ORDER_ZYX);
+        return mtxs[COUNT - 1][0][0];
+    };
+}
+
+TEST_CASE("batched matrix multiplication", "[mathutil][.][benchmark]")
+{
+    constexpr u32 COUNT = 256;
+    static Mtx children[COUNT];
+    static Mtx out_mtxs[COUNT];
+    bench_load_mtxs();
+    Mtx parent;
+    mtxa_to_mtx(&parent);
+    for (u32 i = 0; i < COUNT; i++)
+    {
+        mtxa_rotate_y(0x0123);
+        mtxa_to_mtx(&children[i]);
+    }
+
+    BENCHMARK("mtxa_mult_right() legacy loop")
+    {
+        for (u32 i = 0; i < COUNT; i++)
+        {
+            mtxa_from_mtx(&parent);
+            legacy_mtxa_mult_right(&children[i]);
+            mtxa_to_mtx(&out_mtxs[i]);
+        }
+        return out_mtxs[COUNT - 1][0][0];
+    };
+    BENCHMARK("mtx_mult() loop")
+    {
+        for (u32 i = 0; i < COUNT; i++) mtx_mult(&parent, &children[i], &out_mtxs[i]);
+        return out_mtxs[COUNT - 1][0][0];
+    };
+    BENCHMARK("mtx_mult_batch()")
+    {
+        mtx_mult_batch(&parent, children, out_mtxs, COUNT);
+        return out_mtxs[COUNT - 1][0][0];
+    };
+}
+
+TEST_CASE("quat_from_dirs() latency", "[mathutil][.][benchmark]")
+{
+    Vec3f start = {-0.5f, -1.f, 0.3f};
+    Vec3f end = {-0.25f, -1.83f, 2.032f};
+    Vec3f opposite = {0.5f, 1.f, -0.3f};
+    Quat q;
+
+    BENCHMARK("Quaternionf::FromTwoVectors() legacy")
+    {
+        Eigen::Quaternionf eq(Eigen::Quaternionf::FromTwoVectors(Eigen::Vector3f(&start.x), Eigen::Vector3f(&end.x)));
+        return eq.w();
+    };
+    BENCHMARK("Quaternionf::FromTwoVectors() legacy, opposite directions")
+    {
+        Eigen::Quaternionf eq(
+            Eigen::Quaternionf::FromTwoVectors(Eigen::Vector3f(&start.x), Eigen::Vector3f(&opposite.x)));
+        return eq.w();
+    };
+    BENCHMARK("quat_from_dirs()")
+    {
+        quat_from_dirs(&q, &start, &end);
+        return q.w;
+    };
+    BENCHMARK("quat_from_dirs(), opposite directions")
+    {
+        quat_from_dirs(&q, &start, &opposite);
+        return q.w;
+    };
+}
+
+TEST_CASE("batched quaternion functions", "[mathutil][.][benchmark]")
+{
+    constexpr u32 COUNT = 256;
+    static Quat quats1[COUNT], quats2[COUNT], out_quats[COUNT];
+    static Mtx out_mtxs[COUNT];
+    for (u32 i = 0; i < COUNT; i++)
+    {
+        Vec3f axis = {1.f, (f32) i, 0.5f};
+        quat_from_axis_angle(&quats1[i], &axis, i * 0x0321);
+        quat_from_axis_angle(&quats2[i], &axis, i * -0x0123);
+    }
+
+    BENCHMARK("Quaternionf::slerp() legacy loop")
+    {
+        for (u32 i = 0; i < COUNT; i++)
+        {
+            Eigen::Quaternionf q(Eigen::Quaternionf(&quats1[i].x).slerp(0.3f, Eigen::Quaternionf(&quats2[i].x)));
+            out_quats[i] = {q.x(), q.y(), q.z(), q.w()};
+        }
+        return out_quats[COUNT - 1].w;
+    };
+    BENCHMARK("quat_slerp() loop")
+    {
+        for (u32 i = 0; i < COUNT; i++) quat_slerp(0.3f, &out_quats[i], &quats1[i], &quats2[i]);
+        return out_quats[COUNT - 1].w;
+    };
+    BENCHMARK("quat_slerp_batch() exact")
+    {
+        quat_slerp_batch(0.3f, out_quats, quats1, quats2, COUNT, SLERP_EXACT);
+        return out_quats[COUNT - 1].w;
+    };
+    BENCHMARK("quat_slerp_batch() fast")
+    {
+        quat_slerp_batch(0.3f, out_quats, quats1, quats2, COUNT, SLERP_FAST);
+        return out_quats[COUNT - 1].w;
+    };
+
+    BENCHMARK("Quaternionf multiplication legacy loop")
+    {
+        for (u32 i = 0; i < COUNT; i++)
+        {
+            Eigen::Quaternionf q(Eigen::Quaternionf(&quats1[i].x) * Eigen::Quaternionf(&quats2[i].x));
+            out_quats[i] = {q.x(), q.y(), q.z(), q.w()};
+        }
+        return out_quats[COUNT - 1].w;
+    };
+    BENCHMARK("quat_mult_batch()")
+    {
+        quat_mult_batch(out_quats, quats1, quats2, COUNT);
+        return out_quats[COUNT - 1].w;
+    };
+
+    BENCHMARK("Quaternionf::toRotationMatrix() legacy loop")
+    {
+        for (u32 i = 0; i < COUNT; i++)
+        {
+            Eigen::Map<Eigen::Matrix<f32, 3, 4, Eigen::RowMajor>> emtx(&out_mtxs[i][0][0]);
+            emtx.leftCols<3>() = Eigen::Quaternionf(&quats1[i].x).toRotationMatrix();
+            emtx.col(3).setZero();
+        }
+        return out_mtxs[COUNT - 1][0][0];
+    };
+    BENCHMARK("mtx_from_quat_batch()")
+    {
+        mtx_from_quat_batch(quats1, out_mtxs, COUNT);
+        return out_mtxs[COUNT - 1][0][0];
+    };
+}
+
+TEST_CASE("reciprocal square roots", "[mathutil][.][benchmark]")
+{
+    // Results depend on the LIBMKB_MATH_POLICY build option
+    constexpr u32 COUNT = 1024;
+    static f32 values[COUNT];
+    static Vec3f vecs[COUNT];
+    for (u32 i = 0; i < COUNT; i++)
+    {
+        values[i] = 0.001f + i * 3.7f;
+        vecs[i] = {i * 0.5f, 1.f, -(f32) i};
+    }
+
+    BENCHMARK("math_rsqrt()")
+    {
+        f32 sum = 0.f;
+        for (u32 i = 0; i < COUNT; i++) sum += math_rsqrt(values[i]);
+        return sum;
+    };
+    BENCHMARK("vec_normalize_len()")
+    {
+        f32 sum = 0.f;
+        for (u32 i = 0; i < COUNT; i++)
+        {
+            Vec3f vec = vecs[i];
+            sum += vec_normalize_len(&vec);
+        }
+        return sum;
+    };
+}
+
+
+/*
+ * A typical mix of math primitives: build a direction from an angle, measure its heading, and normalize it.
+ */
+template <typename Policy>
+static f32 math_policy_workload(s16 *angles, f32 *lens, u32 count)
+{
+    using Core = MathCore<Policy>;
+
+    f32 sum = 0.f;
+    for (u32 i = 0; i < count; i++)
+    {
+        f32 sin_cos[2];
+        Core::sin_cos_v(angles[i], sin_cos);
+        f32 x = sin_cos[1] * lens[i];
+        f32 y = sin_cos[0] * lens[i];
+        sum += Core::atan2(y, x) + Core::rsqrt(x * x + y * y) + Core::tan(angles[i] >> 2);
+    }
+    return sum;
+}
+
+TEST_CASE("math policies", "[mathutil][.][benchmark]")
+{
+    constexpr u32 COUNT = 1024;
+    static s16 angles[COUNT];
+    static f32 lens[COUNT];
+    for (u32 i = 0; i < COUNT; i++)
+    {
+        angles[i] = (s16) (i * 0x9e37);
+        lens[i] = 0.5f + i * 0.25f;
+    }
+
+    BENCHMARK("MathPolicyAccurate")
+    {
+        return math_policy_workload<MathPolicyAccurate>(angles, lens, COUNT);
+    };
+    BENCHMARK("MathPolicyFast")
+    {
+        return math_policy_workload<MathPolicyFast>(angles, lens, COUNT);
+    };
+    BENCHMARK("MathPolicyReference")
+    {
+        return math_policy_workload<MathPolicyReference>(angles, lens, COUNT);
+    };
+}
+
+TEST_CASE("deferred Matrix A", "[mathutil][.][benchmark]")
+{
+    constexpr u32 COUNT = 256;
+    static Vec3f points[COUNT];
+    for (u32 i = 0; i < COUNT; i++) points[i] = {i * 0.5f, 1.f, -(f32) i};
+
+    // A typical object transform chain followed by a read, as game code issues them
+    auto transform_chain = []() {
+        Vec3f out = {0.f, 0.f, 0.f};
+        for (u32 i = 0; i < COUNT; i++)
+        {
+            mtxa_from_mtxb();
+            mtxa_translate(&points[i]);
+            mtxa_rotate_z(i * 0x111);
+            mtxa_rotate_y(i * 0x222);
+            mtxa_rotate_x(i * 0x333);
+            mtxa_scale_s(1.5f);
+            Vec3f tf;
+            mtxa_tf_point(&points[i], &tf);
+            out.x += tf.x;
+        }
+        return out.x;
+    };
+
+    bench_load_mtxs();
+    BENCHMARK("eager")
+    {
+        return transform_chain();
+    };
+
+    mtxa_set_deferred(true);
+    BENCHMARK("deferred")
+    {
+        return transform_chain();
+    };
+    mtxa_set_deferred(false);
+}
+
+/*
+ * Legacy `mtxa_to_euler_yxz()`, which rebuilds a Y/X rotation in Matrix A between a push and a pop.
+ */
+static void legacy_mtxa_to_euler_yxz(s16 *out_rot_y, s16 *out_rot_x, s16 *out_rot_z)
+{
+    mtxa_push();
+
+    Vec3f forward = {0.f, 0.f, -1.f};
+    Vec3f up = {0.f, 1.f, 0.f};
+    mtxa_tf_vec(&forward, &forward);
+    mtxa_tf_vec(&up, &up);
+
+    f32 forward_len2d = math_sqrt(forward.x * forward.x + forward.z * forward.z);
+    *out_rot_x = math_atan2(forward.y, forward_len2d);
+    *out_rot_y = math_atan2(forward.x, forward.z) + 0x8000;
+
+    mtxa_from_rotate_y(*out_rot_y);
+    mtxa_rotate_x(*out_rot_x);
+    mtxa_rigid_inv_tf_vec(&up, &up);
+    *out_rot_z = -math_atan2(up.x, up.y);
+
+    mtxa_pop();
+}
+
+TEST_CASE("Euler angle extraction", "[mathutil][.][benchmark]")
+{
+    constexpr u32 COUNT = 256;
+    static Mtx mtxs[COUNT];
+    static Vec3s rots[COUNT];
+    for (u32 i = 0; i < COUNT; i++)
+    {
+        mtxa_from_identity();
+        mtxa_rotate_y(i * 0x1d3);
+        mtxa_rotate_x(i * 0x2f1);
+        mtxa_rotate_z(i * 0x3b7);
+        mtxa_to_mtx(&mtxs[i]);
+    }
+
+    BENCHMARK("mtxa_to_euler_yxz() legacy loop")
+    {
+        for (u32 i = 0; i < COUNT; i++)
+        {
+            mtxa_from_mtx(&mtxs[i]);
+            legacy_mtxa_to_euler_yxz(&rots[i].y, &rots[i].x, &rots[i].z);
+        }
+        return rots[COUNT - 1].z;
+    };
+    BENCHMARK("mtxa_to_euler_yxz() loop")
+    {
+        for (u32 i = 0; i < COUNT; i++)
+        {
+            mtxa_from_mtx(&mtxs[i]);
+            mtxa_to_euler_yxz(&rots[i].y, &rots[i].x, &rots[i].z);
+        }
+        return rots[COUNT - 1].z;
+    };
+    BENCHMARK("mtx_to_euler_batch()")
+    {
+        mtx_to_euler_batch(mtxs, rots, COUNT);
+        return rots[COUNT - 1].z;
+    };
+}
+
+TEST_CASE("batched Euler rotation matrices", "[mathutil][.][benchmark]")
+{
+    constexpr u32 COUNT = 256;
+    static Vec3s rots[COUNT];
+    static Mtx out_mtxs[COUNT];
+    for (u32 i = 0; i < COUNT; i++)
+    {
+        rots[i] = {(s16) (i * 0x1357), (s16) (-0x2a00 + i * 0x0bcd), (s16) (0x7fff - i * 0x2222)};
+    }
+
+    BENCHMARK("mtxa_rotate_z/y/x() loop")
+    {
+        for (u32 i = 0; i < COUNT; i++)
+        {
+            mtxa_from_identity();
+            mtxa_rotate_z(rots[i].z);
+            mtxa_rotate_y(rots[i].y);
+            mtxa_rotate_x(rots[i].x);
+            mtxa_to_mtx(&out_mtxs[i]);
+        }
+        return out_mtxs[COUNT - 1][0][0];
+    };
+    BENCHMARK("mtx_from_trs() loop")
+    {
+        Vec3f zero = {0.f, 0.f, 0.f};
+        Vec3f one = {1.f, 1.f, 1.f};
+        for (u32 i = 0; i < COUNT; i++) mtx_from_trs(&out_mtxs[i], &zero, &rots[i], &one, EULER_ORDER_ZYX);
+        return out_mtxs[COUNT - 1][0][0];
+    };
+    BENCHMARK("mtx_from_euler_batch()")
+    {
+        mtx_from_euler_batch(rots, out_mtxs, COUNT, EULER_ORDER_ZYX);
+        return out_mtxs[COUNT - 1][0][0];
+    };
+}
+
+TEST_CASE("bulk vector functions", "[mathutil][.][benchmark]")
+{
+    // As many vectors as there are effects
+    constexpr u32 COUNT = 512;
+    static Vec3f vecs1[COUNT], vecs2[COUNT], out_vecs[COUNT];
+    static f32 xs[COUNT], ys[COUNT], zs[COUNT], out_xs[COUNT], out_ys[COUNT], out_zs[COUNT];
+    static f32 out_lens[COUNT];
+    for (u32 i = 0; i < COUNT; i++)
+    {
+        vecs1[i] = {i * 0.5f, 1.f, -(f32) i};
+        vecs2[i] = {-1.f, i * 0.25f, 3.f};
+        xs[i] = vecs1[i].x;
+        ys[i] = vecs1[i].y;
+        zs[i] = vecs1[i].z;
+    }
+    Vec3fSoa soa = {xs, ys, zs};
+    Vec3fSoa out_soa = {out_xs, out_ys, out_zs};
+
+    BENCHMARK("vec_set_len() loop")
+    {
+        for (u32 i = 0; i < COUNT; i++) vec_set_len(2.f, &vecs1[i], &out_vecs[i]);
+        return out_vecs[COUNT - 1].x;
+    };
+    BENCHMARK("vec_set_len_batch()")
+    {
+        vec_set_len_batch(2.f, vecs1, out_vecs, COUNT);
+        return out_vecs[COUNT - 1].x;
+    };
+    BENCHMARK("vec_set_len_soa()")
+    {
+        vec_set_len_soa(2.f, &soa, &out_soa, COUNT);
+        return out_xs[COUNT - 1];
+    };
+
+    BENCHMARK("vec_normalize_len() loop")
+    {
+        for (u32 i = 0; i < COUNT; i++)
+        {
+            out_vecs[i] = vecs1[i];
+            out_lens[i] = vec_normalize_len(&out_vecs[i]);
+        }
+        return out_lens[COUNT - 1];
+    };
+    BENCHMARK("vec_normalize_len_batch()")
+    {
+        memcpy(out_vecs, vecs1, sizeof(vecs1));
+        vec_normalize_len_batch(out_vecs, out_lens, COUNT);
+        return out_lens[COUNT - 1];
+    };
+
+    BENCHMARK("vec_dot_normalized_safe() loop")
+    {
+        for (u32 i = 0; i < COUNT; i++) out_lens[i] = vec_dot_normalized_safe(&vecs1[i], &vecs2[i]);
+        return out_lens[COUNT - 1];
+    };
+    BENCHMARK("vec_dot_normalized_safe_batch()")
+    {
+        vec_dot_normalized_safe_batch(vecs1, vecs2, out_lens, COUNT);
+        return out_lens[COUNT - 1];
+    };
+}
+
+TEST_CASE("aligned types", "[mathutil][.][benchmark]")
+{
+    constexpr u32 COUNT = 1024;
+    static Vec3f src[COUNT], dst[COUNT];
+    static Vec3fA src_a[COUNT], dst_a[COUNT];
+    for (u32 i = 0; i < COUNT; i++)
+    {
+        src[i] = {i * 0.25f, i * -0.5f, 3.f - i};
+        src_a[i] = vec3fa_from_vec3f(&src[i]);
+    }
+    static Mtx mtxs[2];
+    static AlignedMtx mtxs_a[2];
+    bench_load_mtxs();
+    mtxa_to_mtx(&mtxs[0]);
+    mtxa_to_mtx(&mtxs_a[0]);
+    mtxa_to_mtxb();
+    mtxa_rotate_x(0x2345);
+    mtxa_to_mtx(&mtxs[1]);
+    mtxa_to_mtx(&mtxs_a[1]);
+
+    BENCHMARK("mtxa_tf_point() loop, Vec3f")
+    {
+        for (u32 i = 0; i < COUNT; i++) mtxa_tf_point(&src[i], &dst[i]);
+        return dst[COUNT - 1].x;
+    };
+    BENCHMARK("mtxa_tf_point() loop, Vec3fA")
+    {
+        for (u32 i = 0; i < COUNT; i++) mtxa_tf_point(&src_a[i], &dst_a[i]);
+        return dst_a[COUNT - 1].x;
+    };
+    BENCHMARK("mtxa_tf_points(), Vec3f")
+    {
+        mtxa_tf_points(src, dst, COUNT);
+        return dst[COUNT - 1].x;
+    };
+    BENCHMARK("mtxa_tf_points(), Vec3fA")
+    {
+        mtxa_tf_points(src_a, dst_a, COUNT);
+        return dst_a[COUNT - 1].x;
+    };
+    BENCHMARK("mtxa_rigid_inv_tf_point() loop, Vec3f")
+    {
+        for (u32 i = 0; i < COUNT; i++) mtxa_rigid_inv_tf_point(&src[i], &dst[i]);
+        return dst[COUNT - 1].x;
+    };
+    BENCHMARK("mtxa_rigid_inv_tf_point() loop, Vec3fA")
+    {
+        for (u32 i = 0; i < COUNT; i++) mtxa_rigid_inv_tf_point(&src_a[i], &dst_a[i]);
+        return dst_a[COUNT - 1].x;
+    };
+    BENCHMARK("mtx_mult() loop, Mtx")
+    {
+        for (u32 i = 0; i < COUNT; i++) mtx_mult(&mtxs[0], &mtxs[1], &mtxs[1]);
+        return mtxs[1][0][0];
+    };
+    BENCHMARK("mtx_mult() loop, AlignedMtx")
+    {
+        for (u32 i = 0; i < COUNT; i++) mtx_mult(&mtxs_a[0], &mtxs_a[1], &mtxs_a[1]);
+        return mtxs_a[1].m[0][0];
+    };
+}
+
+TEST_CASE("point projection", "[mathutil][.][benchmark]")
+{
+    constexpr u32 COUNT = 1024;
+    static Vec3f points[COUNT], screen_points[COUNT];
+    static u8 clip_flags[COUNT];
+    for (u32 i = 0; i < COUNT; i++) points[i] = {i * 0.25f - 128.f, i * -0.125f + 64.f, -3.f - i};
+    Viewport viewport = {0.f, 0.f, 640.f, 480.f};
+    Mtx44 proj, view_proj;
+    mtx44_from_perspective(&proj, 0x2aaa, 640.f / 480.f, 0.1f, 20000.f);
+    bench_load_mtxs();
+    Mtx view;
+    mtxa_to_mtx(&view);
+    mtx44_mult_mtx(&proj, &view, &view_proj);
+
+    BENCHMARK("mtx44_project_point() loop")
+    {
+        for (u32 i = 0; i < COUNT; i++)
+        {
+            clip_flags[i] = mtx44_project_point(&view_proj, &viewport, &points[i], &screen_points[i]);
+        }
+        return screen_points[COUNT - 1].x;
+    };
+    BENCHMARK("mtx44_project_points()")
+    {
+        mtx44_project_points(&view_proj, &viewport, points, screen_points, clip_flags, COUNT);
+        return screen_points[COUNT - 1].x;
+    };
+}
\ No newline at end of file
@@ -1,7 +1,11 @@
 #include <catch.hpp>
 
 #include "mathutil.h"
+#include "mathpolicy.h"
+#include "vecutil.h"
 #include "global_state.h"
+#include "stagedef.h"
+#include "test_rand.h"
 
 using namespace mkb2;
 
@@ -155,6 +159,20 @@ Ufmtx gen_dummy_ufmtx2()
     };
 }
 
+/*
+ * Fill `vecs` with deterministic pseudo-random vectors with components in [-range, range].
+ */
+void gen_test_vecs(Vec3f *vecs, u32 count, f32 range)
+{
+    u32 state = 0x1234567;
+    for (u32 i = 0; i < count; i++)
+    {
+        vecs[i].x = test_rand_f32(state, range);
+        vecs[i].y = test_rand_f32(state, range);
+        vecs[i].z = test_rand_f32(state, range);
+    }
+}
+
 TEST_CASE("math_sqrt()", "[mathutil]")
 {
     Uf64 a, b;
@@ -185,6 +203,168 @@ TEST_CASE("math_rsqrt()", "[mathutil]")
     CHECK(math_rsqrt(a.f) == Approx(c.f));
 }
 
+TEST_CASE("math_rsqrt() is accurate over a wide range", "[mathutil]")
+{
+    f64 max_rel_err = 0.0;
+    for (f64 x = 1e-30; x < 1e30; x *= 1.0137)
+    {
+        max_rel_err = fmax(max_rel_err, fabs(math_rsqrt(x) * sqrt(x) - 1.0));
+    }
+    REQUIRE(max_rel_err <= 2e-6);
+}
+
+TEST_CASE("math_frsqrte()", "[mathutil]")
+{
+    f64 max_rel_err = 0.0;
+    for (f64 x = 1e-300; x < 1e300; x *= 1.0173)
+    {
+        max_rel_err = fmax(max_rel_err, fabs(math_frsqrte(x) * sqrt(x) - 1.0));
+    }
+
+    // Denormals
+    for (f64 x = 4.9406564584124654e-324; x < 2.2250738585072014e-308; x *= 1.5)
+    {
+        max_rel_err = fmax(max_rel_err, fabs(math_frsqrte(x) * sqrt(x) - 1.0));
+    }
+    REQUIRE(max_rel_err <= 1.0 / 4096);
+
+    // Just below a power of 4, where the table's last even-exponent segment would go negative
+    for (f64 power = 0x1p-1020; power < 0x1p1020; power *= 4.0)
+    {
+        for (f64 x = power * 0.985; x < power; x += power * 1e-3)
+        {
+            f64 estimate = math_frsqrte(x);
+            REQUIRE(estimate > 0.0);
+            REQUIRE(fabs(estimate * sqrt(x) - 1.0) <= 1.0 / 4096);
+        }
+        f64 x = nextafter(power, 0.0);
+        REQUIRE(math_frsqrte(x) == 1.0 / sqrt(power));
+    }
+
+    REQUIRE(math_frsqrte(0.0) == INFINITY);
+    REQUIRE(math_frsqrte(-0.0) == -INFINITY);
+    REQUIRE(math_frsqrte(INFINITY) == 0.0);
+    REQUIRE(isnan(math_frsqrte(-1.0)));
+    REQUIRE(isnan(math_frsqrte(-INFINITY)));
+    REQUIRE(isnan(math_frsqrte(NAN)));
+}
+
+template <typename Policy>
+static void check_math_policy_vs_reference()
+{
+    using Core = MathCore<Policy>;
+    using Ref = MathCore<MathPolicyReference>;
+
+    for (s32 angle = -0x8000; angle < 0x8000; angle += 7)
+    {
+        f32 sin_cos[2], ref_sin_cos[2];
+        Core::sin_cos_v(angle, sin_cos);
+        Ref::sin_cos_v(angle, ref_sin_cos);
+        REQUIRE(sin_cos[0] == Approx(ref_sin_cos[0]).margin(1e-7));
+        REQUIRE(sin_cos[1] == Approx(ref_sin_cos[1]).margin(1e-7));
+        REQUIRE(Core::sin(angle) == sin_cos[0]);
+
+        // Truncation to s16 may differ by one step
+        s16 atan2 = Core::atan2(ref_sin_cos[0], ref_sin_cos[1]);
+        REQUIRE(abs((s16) (atan2 - Ref::atan2(ref_sin_cos[0], ref_sin_cos[1]))) <= 1);
+    }
+
+    for (f64 x = 1e-20; x < 1e20; x *= 1.37)
+    {
+        f32 sqrt;
+        f32 rsqrt = Core::sqrt_rsqrt(x, &sqrt);
+        REQUIRE(rsqrt == Approx(Ref::rsqrt(x)).epsilon(2e-6));
+        REQUIRE(sqrt == Approx(Ref::sqrt(x)).epsilon(2e-6));
+        REQUIRE(Core::rsqrt(x) == rsqrt);
+    }
+    REQUIRE(Core::rsqrt(0.0) == INFINITY);
+    REQUIRE(Core::sqrt(-1.0) == 0.f);
+}
+
+TEST_CASE("reference math policy matches libm exactly", "[mathutil]")
+{
+    using Ref = MathCore<MathPolicyReference>;
+
+    // Square roots of f32-rounded inputs, like libmkb before math policies. Inputs span magnitudes which are denormal
+    // or overflow as f32
+    constexpr u32 COUNT = 40000;
+    static Vec3f exponents[COUNT];
+    gen_test_vecs(exponents, COUNT, 50.f);
+    for (u32 i = 0; i < COUNT; i++)
+    {
+        f64 x = pow(10.0, exponents[i].x) * (exponents[i].y + 50.f);
+        f32 sqrt;
+        f32 rsqrt = Ref::sqrt_rsqrt(x, &sqrt);
+        REQUIRE(Ref::sqrt(x) == sqrtf((f32) x));
+        REQUIRE(Ref::rsqrt(x) == 1.f / sqrtf((f32) x));
+        REQUIRE(sqrt == sqrtf((f32) x));
+        REQUIRE(rsqrt == 1.f / sqrtf((f32) x));
+
+        f64 atan_y = exponents[i].y;
+        f64 atan_x = exponents[i].z;
+        REQUIRE(Ref::atan2(atan_y, atan_x) == (s16) (s32) (::atan2(atan_y, atan_x) * 0x8000 / M_PI));
+    }
+
+    for (s32 i = -0x8000; i < 0x8000; i++)
+    {
+        f64 angle_rad = i * M_PI / 0x8000;
+        f32 sin_cos[2];
+        Ref::sin_cos_v(i, sin_cos);
+        REQUIRE(Ref::sin(i) == (f32) sin(angle_rad));
+        REQUIRE(sin_cos[0] == (f32) sin(angle_rad));
+        REQUIRE(sin_cos[1] == (f32) cos(angle_rad));
+        REQUIRE(Ref::tan(i) == (f32) tan(angle_rad));
+    }
+}
+
+TEST_CASE("math policies agree with the reference policy", "[mathutil]")
+{
+    check_math_policy_vs_reference<MathPolicyAccurate>();
+    check_math_policy_vs_reference<MathPolicyFast>();
+}
+
+template <typename Policy>
+static void check_math_policy_sqrt_edge_cases()
+{
+    using Core = MathCore<Policy>;
+
+    // Inputs which are denormal, zero, huge, or infinite after conversion to f32
+    for (f64 x : {1e-40, 1e-39, 1e-38, 1e-50, 1e39, (f64) INFINITY})
+    {
+        f32 sqrt;
+        f32 rsqrt = Core::sqrt_rsqrt(x, &sqrt);
+        REQUIRE(Core::rsqrt(x) == rsqrt);
+        REQUIRE(Core::sqrt(x) == sqrt);
+        REQUIRE(rsqrt >= 0.f);
+        REQUIRE(sqrt >= 0.f);
+    }
+
+    f32 sqrt;
+    REQUIRE(Core::sqrt_rsqrt(1e-40, &sqrt) == Approx(1e20f).epsilon(1e-3));
+    REQUIRE(sqrt == Approx(1e-20f).epsilon(1e-3));
+    REQUIRE(Core::sqrt_rsqrt(1e-50, &sqrt) >= 1e24f);
+    REQUIRE(sqrt <= 1e-24f);
+    REQUIRE(Core::sqrt_rsqrt(1e39, &sqrt) <= 1e-19f);
+    REQUIRE(sqrt >= 1e19f);
+    REQUIRE(Core::sqrt_rsqrt(INFINITY, &sqrt) == 0.f);
+    REQUIRE(sqrt == INFINITY);
+}
+
+TEST_CASE("math policies handle denormal, tiny, huge, and infinite inputs", "[mathutil]")
+{
+    check_math_policy_sqrt_edge_cases<MathPolicyAccurate>();
+    check_math_policy_sqrt_edge_cases<MathPolicyFast>();
+    check_math_policy_sqrt_edge_cases<MathPolicyReference>();
+
+    // The squared length is a denormal with only a few bits of precision
+    Vec3f vec = {1e-22f, 0.f, 0.f};
+    f32 len = vec_normalize_len(&vec);
+    CHECK(len == Approx(1e-22f).epsilon(0.02));
+    CHECK(vec.x == Approx(1.f).epsilon(0.02));
+    CHECK(vec.y == 0.f);
+    CHECK(vec.z == 0.f);
+}
+
 TEST_CASE("math_sqrt_rsqrt()", "[mathutil]")
 {
     Uf64 a, b;
@@ -218,6 +398,49 @@ TEST_CASE("math_sin()", "[mathutil]")
     CHECK(math_sin(angle) == Approx(a.f));
 }
 
+template <typename Policy>
+static void check_math_tan()
+{
+    using Core = MathCore<Policy>;
+
+    // The cosine is zero here, so the result must come from the side where the cosine is positive
+    CHECK(Core::tan(0x4000) == (f32) tan(0x4000 * M_PI / 0x8000));
+    CHECK(Core::tan(0x4000) > 1e15f);
+    CHECK(Core::tan(-0x4000) < -1e15f);
+    CHECK(std::isfinite(Core::tan(0x4000)));
+    CHECK(Core::tan(0x3fff) > 0.f);
+    CHECK(Core::tan(0x2000) == Approx(1.f));
+    CHECK(Core::tan(0) == 0.f);
+}
+
+TEST_CASE("math_tan()", "[mathutil]")
+{
+    check_math_tan<MathPolicyAccurate>();
+    check_math_tan<MathPolicyFast>();
+    check_math_tan<MathPolicyReference>();
+
+    // Perspective matrices take the reciprocal of the half-FOV's tangent
+    CHECK(1.f / math_tan(0x4000) >= 0.f);
+}
+
+TEST_CASE("math_sin_cos_v() matches libm over all angles", "[mathutil]")
+{
+    f64 max_err = 0.0;
+    for (s32 i = -0x8000; i < 0x8000; i++)
+    {
+        s16 angle = i;
+        f64 angle_rad = i * M_PI / 0x8000;
+        f32 sin_cos[2];
+        math_sin_cos_v(angle, sin_cos);
+        max_err = std::max(max_err, fabs(sin_cos[0] - sin(angle_rad)));
+        max_err = std::max(max_err, fabs(sin_cos[1] - cos(angle_rad)));
+        max_err = std::max(max_err, fabs(math_sin(angle) - sin(angle_rad)));
+    }
+
+    // Within f32 rounding of the exact value
+    CHECK(max_err <= 6e-8);
+}
+
 TEST_CASE("math_atan2()", "[mathutil]")
 {
     Uf64 a, b;
@@ -252,6 +475,41 @@ TEST_CASE("math_atan2()", "[mathutil]")
     CHECK(abs(math_atan2(a.f, b.f) - angle) <= 1);
 }
 
+TEST_CASE("math_atan2() and math_atan() match libm over a dense grid", "[mathutil]")
+{
+    // Reference implementation using libm
+    auto ref_atan2 = [](f64 y, f64 x) { return (s16) (s32) (atan2(y, x) * 0x8000 / M_PI); };
+
+    u32 mismatches = 0;
+    for (s32 i = -400; i <= 400; i++)
+    {
+        for (s32 j = -400; j <= 400; j++)
+        {
+            f64 y = i * 0.0137;
+            f64 x = j * 0.0291;
+            if (math_atan2(y, x) != ref_atan2(y, x)) mismatches++;
+            if (math_atan2(y, y * 1e-12) != ref_atan2(y, y * 1e-12)) mismatches++;
+            if (math_atan2(x * 1e-12, -x) != ref_atan2(x * 1e-12, -x)) mismatches++;
+        }
+    }
+
+    for (s32 i = -50000; i < 50000; i++)
+    {
+        f64 x = i * 0.00173;
+        if (math_atan(x) != ref_atan2(x, 1.0)) mismatches++;
+    }
+
+    CHECK(mismatches == 0);
+
+    // Special values
+    CHECK(math_atan2(0.0, 0.0) == 0);
+    CHECK(math_atan2(0.0, -1.0) == -0x8000);
+    CHECK(math_atan2(-0.0, -1.0) == -0x8000);
+    CHECK(math_atan2(1.0, 0.0) == 0x4000);
+    CHECK(math_atan2(-INFINITY, 1.0) == -0x4000);
+    CHECK(math_atan(INFINITY) == 0x4000);
+}
+
 TEST_CASE("math_sin_cos_v()", "[mathutil]")
 {
     Ufarr32 arr1, arr2;
@@ -348,6 +606,105 @@ TEST_CASE("vec_normalize_len()", "[mathutil]")
     CHECK(len == Approx(expected_len.f));
 }
 
+TEST_CASE("bulk vector functions match their single-vector counterparts", "[mathutil]")
+{
+    constexpr u32 COUNT = 47;
+    Vec3f vecs1[COUNT], vecs2[COUNT];
+    gen_test_vecs(vecs1, COUNT, 100.f);
+    gen_test_vecs(vecs2, COUNT, 1.f);
+    std::reverse(vecs2, vecs2 + COUNT);
+
+    // Zero, infinite, NAN, tiny, and huge vectors, and orthogonal pairs
+    vecs1[1] = {0.f, 0.f, 0.f};
+    vecs1[2] = {INFINITY, 1.f, 0.f};
+    vecs2[3] = {0.f, -INFINITY, 0.f};
+    vecs1[4] = {NAN, 1.f, 2.f};
+    vecs1[5] = {1e-30f, 0.f, 0.f};
+    vecs1[6] = {3e20f, -3e20f, 1e20f};
+    vecs1[7] = {1.f, 0.f, 0.f};
+    vecs2[7] = {0.f, 0.f, 1.f};
+    vecs2[8] = {0.f, 0.f, 0.f};
+    vecs1[45] = {0.f, 0.f, 0.f};
+
+    f32 xs[COUNT], ys[COUNT], zs[COUNT], xs2[COUNT], ys2[COUNT], zs2[COUNT];
+    for (u32 i = 0; i < COUNT; i++)
+    {
+        xs[i] = vecs1[i].x;
+        ys[i] = vecs1[i].y;
+        zs[i] = vecs1[i].z;
+        xs2[i] = vecs2[i].x;
+        ys2[i] = vecs2[i].y;
+        zs2[i] = vecs2[i].z;
+    }
+    Vec3fSoa soa1 = {xs, ys, zs};
+    Vec3fSoa soa2 = {xs2, ys2, zs2};
+
+    auto check_soa = [&](Vec3fSoa *soa, Vec3f *expected) {
+        for (u32 i = 0; i < COUNT; i++)
+        {
+            Vec3f vec = {soa->x[i], soa->y[i], soa->z[i]};
+            REQUIRE(memcmp(&vec, &expected[i], sizeof(Vec3f)) == 0);
+        }
+    };
+
+    SECTION("vec_normalize_len_*()")
+    {
+        Vec3f expected[COUNT], result[COUNT];
+        f32 expected_lens[COUNT], result_lens[COUNT], soa_lens[COUNT];
+        memcpy(expected, vecs1, sizeof(vecs1));
+        memcpy(result, vecs1, sizeof(vecs1));
+        for (u32 i = 0; i < COUNT; i++) expected_lens[i] = vec_normalize_len(&expected[i]);
+
+        vec_normalize_len_batch(result, result_lens, COUNT);
+        REQUIRE(memcmp(result, expected, sizeof(expected)) == 0);
+        REQUIRE(memcmp(result_lens, expected_lens, sizeof(expected_lens)) == 0);
+
+        vec_normalize_len_soa(&soa1, soa_lens, COUNT);
+        check_soa(&soa1, expected);
+        REQUIRE(memcmp(soa_lens, expected_lens, sizeof(expected_lens)) == 0);
+
+        memcpy(result, vecs1, sizeof(vecs1));
+        vec_normalize_len_batch(result, nullptr, COUNT);
+        REQUIRE(memcmp(result, expected, sizeof(expected)) == 0);
+    }
+
+    SECTION("vec_set_len_*()")
+    {
+        Vec3f expected[COUNT], result[COUNT];
+        for (u32 i = 0; i < COUNT; i++) vec_set_len(2.5f, &vecs1[i], &expected[i]);
+
+        vec_set_len_batch(2.5f, vecs1, result, COUNT);
+        REQUIRE(memcmp(result, expected, sizeof(expected)) == 0);
+
+        // In place
+        vec_set_len_soa(2.5f, &soa1, &soa1, COUNT);
+        check_soa(&soa1, expected);
+    }
+
+    SECTION("vec_dot_normalized*_*()")
+    {
+        f32 expected[COUNT], expected_safe[COUNT], result[COUNT];
+        for (u32 i = 0; i < COUNT; i++)
+        {
+            expected[i] = vec_dot_normalized(&vecs1[i], &vecs2[i]);
+            expected_safe[i] = vec_dot_normalized_safe(&vecs1[i], &vecs2[i]);
+        }
+        REQUIRE(expected_safe[1] == 0.f);
+        REQUIRE(expected_safe[2] == INFINITY);
+        REQUIRE(expected_safe[3] == INFINITY);
+        REQUIRE(expected_safe[7] == 0.f);
+
+        vec_dot_normalized_batch(vecs1, vecs2, result, COUNT);
+        REQUIRE(memcmp(result, expected, sizeof(expected)) == 0);
+        vec_dot_normalized_soa(&soa1, &soa2, result, COUNT);
+        REQUIRE(memcmp(result, expected, sizeof(expected)) == 0);
+        vec_dot_normalized_safe_batch(vecs1, vecs2, result, COUNT);
+        REQUIRE(memcmp(result, expected_safe, sizeof(expected_safe)) == 0);
+        vec_dot_normalized_safe_soa(&soa1, &soa2, result, COUNT);
+        REQUIRE(memcmp(result, expected_safe, sizeof(expected_safe)) == 0);
+    }
+}
+
 TEST_CASE("mtxa_from_identity()", "[mathutil]")
 {
     load_dummy_mtxa();
@@ -408,6 +765,265 @@ TEST_CASE("mtxa_from_translate_xyz*()", "[mathutil]")
     check_mtxa(expected);
 }
 
+TEST_CASE("mtxa_rotate_x/y/z() match multiplying by mtxa_from_rotate_x/y/z()", "[mathutil]")
+{
+    void (*rotate_funcs[3])(s16) = {mtxa_rotate_x, mtxa_rotate_y, mtxa_rotate_z};
+    void (*from_rotate_funcs[3])(s16) = {mtxa_from_rotate_x, mtxa_from_rotate_y, mtxa_from_rotate_z};
+    s16 angles[] = {0, 0x38a5, -0x6803, 0x4000, -0x8000};
+
+    for (s32 axis = 0; axis < 3; axis++)
+    {
+        for (s16 angle : angles)
+        {
+            Mtx rot, expected;
+            from_rotate_funcs[axis](angle);
+            mtxa_to_mtx(&rot);
+
+            load_dummy_mtxa();
+            mtxa_mult_right(&rot);
+            mtxa_to_mtx(&expected);
+
+            load_dummy_mtxa();
+            rotate_funcs[axis](angle);
+            check_mtx(&gs->mtxa_raw, &expected);
+        }
+    }
+}
+
+TEST_CASE("mtxa_from_trs() and mtx_from_trs_batch() match chained transforms", "[mathutil]")
+{
+    constexpr u32 COUNT = 12;
+    void (*rotate_funcs[3])(s16) = {mtxa_rotate_x, mtxa_rotate_y, mtxa_rotate_z};
+    s32 order_axes[6][3] = {{0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}};
+
+    StagedefBumper bumpers[COUNT] = {};
+    Vec3f vecs[COUNT * 2];
+    gen_test_vecs(vecs, COUNT * 2, 50.f);
+    for (u32 i = 0; i < COUNT; i++)
+    {
+        bumpers[i].position = vecs[i];
+        bumpers[i].rotation = {(s16) (i * 0x1357), (s16) (-0x2a00 + i * 0x0bcd), (s16) (0x7fff - i * 0x2222)};
+        bumpers[i].scale = vecs[COUNT + i];
+    }
+
+    for (s32 order = EULER_ORDER_XYZ; order <= EULER_ORDER_ZYX; order++)
+    {
+        Mtx mtxs[COUNT];
+        load_dummy_mtxa();
+        Mtx dummy;
+        mtxa_to_mtx(&dummy);
+        mtx_from_trs_batch(bumpers, mtxs, COUNT, (EulerOrder) order);
+        REQUIRE(memcmp(&gs->mtxa_raw, &dummy, sizeof(Mtx)) == 0);
+
+        for (u32 i = 0; i < COUNT; i++)
+        {
+            s16 angles[3] = {bumpers[i].rotation.x, bumpers[i].rotation.y, bumpers[i].rotation.z};
+            mtxa_from_translate(&bumpers[i].position);
+            for (s32 axis : order_axes[order]) rotate_funcs[axis](angles[axis]);
+            mtxa_scale(&bumpers[i].scale);
+            check_mtx(&mtxs[i], &gs->mtxa_raw);
+
+            mtxa_from_trs(&bumpers[i].position, &bumpers[i].rotation, &bumpers[i].scale, (EulerOrder) order);
+            REQUIRE(memcmp(&gs->mtxa_raw, &mtxs[i], sizeof(Mtx)) == 0);
+        }
+    }
+}
+
+TEST_CASE("mtx_from_euler_batch() matches chained rotations", "[mathutil]")
+{
+    constexpr u32 COUNT = 23;
+    void (*rotate_funcs[3])(s16) = {mtxa_rotate_x, mtxa_rotate_y, mtxa_rotate_z};
+    s32 order_axes[6][3] = {{0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}};
+
+    Vec3s rots[COUNT];
+    for (u32 i = 0; i < COUNT; i++)
+    {
+        rots[i] = {(s16) (i * 0x1357), (s16) (-0x2a00 + i * 0x0bcd), (s16) (0x7fff - i * 0x2222)};
+    }
+    rots[0] = {0, 0, 0};
+    rots[1] = {0x4000, -0x4000, -0x8000};
+
+    for (s32 order = EULER_ORDER_XYZ; order <= EULER_ORDER_ZYX; order++)
+    {
+        Mtx mtxs[COUNT];
+        load_dummy_mtxa();
+        Mtx dummy;
+        mtxa_to_mtx(&dummy);
+        mtx_from_euler_batch(rots, mtxs, COUNT, (EulerOrder) order);
+        REQUIRE(memcmp(&gs->mtxa_raw, &dummy, sizeof(Mtx)) == 0);
+
+        for (u32 i = 0; i < COUNT; i++)
+        {
+            s16 angles[3] = {rots[i].x, rots[i].y, rots[i].z};
+            mtxa_from_identity();
+            for (s32 axis : order_axes[order]) rotate_funcs[axis](angles[axis]);
+
+            // Equal values, though the signs of zero elements may differ
+            for (s32 row = 0; row < 3; row++)
+            {
+                for (s32 col = 0; col < 4; col++) REQUIRE(mtxs[i][row][col] == gs->mtxa_raw[row][col]);
+            }
+
+            Vec3f zero = {0.f, 0.f, 0.f};
+            Vec3f one = {1.f, 1.f, 1.f};
+            Mtx trs;
+            mtx_from_trs(&trs, &zero, &rots[i], &one, (EulerOrder) order);
+            REQUIRE(memcmp(&trs, &mtxs[i], sizeof(Mtx)) == 0);
+        }
+    }
+}
+
+TEST_CASE("mtx44 projection", "[mathutil]")
+{
+    Viewport viewport = {0.f, 0.f, 640.f, 480.f};
+    Mtx44 proj;
+    Vec3f screen;
+
+    SECTION("perspective")
+    {
+        // 90 degree vertical FOV, so the top edge of the view is at y = -z
+        mtx44_from_perspective(&proj, 0x4000, 640.f / 480.f, 0.1f, 1000.f);
+
+        Vec3f point = {0.f, 0.f, -0.1f};
+        CHECK(mtx44_project_point(&proj, &viewport, &point, &screen) == 0);
+        CHECK(screen.x == Approx(320.f));
+        CHECK(screen.y == Approx(240.f));
+        CHECK(screen.z == Approx(-1.f));
+
+        point = {0.f, 5.f, -10.f};
+        CHECK(mtx44_project_point(&proj, &viewport, &point, &screen) == 0);
+        CHECK(screen.y == Approx(120.f));
+        point = {-10.f * 640.f / 480.f, -10.f, -10.f};
+        mtx44_project_point(&proj, &viewport, &point, &screen);
+        CHECK(screen.x == Approx(0.f).margin(0.001f));
+        CHECK(screen.y == Approx(480.f));
+
+        point = {0.f, 0.f, -999.f};
+        CHECK(mtx44_project_point(&proj, &viewport, &point, &screen) == 0);
+        CHECK(screen.z == Approx(0.f).margin(0.001f));
+
+        point = {-20.f, 0.f, -10.f};
+        CHECK(mtx44_project_point(&proj, &viewport, &point, &screen) == CLIP_LEFT);
+        point = {20.f, 20.f, -10.f};
+        CHECK(mtx44_project_point(&proj, &viewport, &point, &screen) == (CLIP_RIGHT | CLIP_TOP));
+        point = {0.f, -11.f, -10.f};
+        CHECK(mtx44_project_point(&proj, &viewport, &point, &screen) == CLIP_BOTTOM);
+        point = {0.f, 0.f, -0.05f};
+        CHECK(mtx44_project_point(&proj, &viewport, &point, &screen) == CLIP_NEAR);
+        point = {0.f, 0.f, 10.f};
+        CHECK((mtx44_project_point(&proj, &viewport, &point, &screen) & CLIP_NEAR) != 0);
+        point = {0.f, 0.f, -1001.f};
+        CHECK(mtx44_project_point(&proj, &viewport, &point, &screen) == CLIP_FAR);
+    }
+
+    SECTION("ortho")
+    {
+        mtx44_from_ortho(&proj, 10.f, -10.f, -20.f, 20.f, 1.f, 100.f);
+
+        Vec3f point = {-20.f, 10.f, -1.f};
+        CHECK(mtx44_project_point(&proj, &viewport, &point, &screen) == 0);
+        CHECK(screen.x == Approx(0.f).margin(0.001f));
+        CHECK(screen.y == Approx(0.f).margin(0.001f));
+        CHECK(screen.z == Approx(-1.f));
+
+        point = {10.f, -5.f, -100.f};
+        CHECK(mtx44_project_point(&proj, &viewport, &point, &screen) == 0);
+        CHECK(screen.x == Approx(480.f));
+        CHECK(screen.y == Approx(360.f));
+        CHECK(screen.z == Approx(0.f).margin(0.001f));
+
+        point = {30.f, 0.f, -200.f};
+        CHECK(mtx44_project_point(&proj, &viewport, &point, &screen) == (CLIP_RIGHT | CLIP_FAR));
+    }
+
+    SECTION("view matrix")
+    {
+        mtx44_from_perspective(&proj, 0x3000, 640.f / 480.f, 0.1f, 1000.f);
+        load_dummy_mtxa();
+        Mtx view;
+        mtxa_to_mtx(&view);
+
+        Mtx44 view_proj;
+        mtx44_mult_mtx(&proj, &view, &view_proj);
+
+        Vec3f point = {3.f, -4.f, 5.f};
+        Vec3f view_point, expected;
+        mtxa_tf_point(&point, &view_point);
+        u8 expected_flags = mtx44_project_point(&proj, &viewport, &view_point, &expected);
+        CHECK(mtx44_project_point(&view_proj, &viewport, &point, &screen) == expected_flags);
+        CHECK(screen.x == Approx(expected.x));
+        CHECK(screen.y == Approx(expected.y));
+        CHECK(screen.z == Approx(expected.z));
+
+        // In-place
+        mtx44_mult_mtx(&proj, &view, &proj);
+        REQUIRE(memcmp(proj, view_proj, sizeof(Mtx44)) == 0);
+    }
+
+    SECTION("mtx44_project_points() matches mtx44_project_point()")
+    {
+        // Odd count to cover the non-SIMD remainder
+        constexpr u32 COUNT = 39;
+        Vec3f points[COUNT], expected[COUNT], result[COUNT];
+        u8 expected_flags[COUNT], result_flags[COUNT];
+        gen_test_vecs(points, COUNT, 50.f);
+        points[2] = {0.f, 0.f, 0.f};
+        points[3] = {NAN, 0.f, -10.f};
+        mtx44_from_perspective(&proj, 0x2800, 640.f / 480.f, 1.f, 60.f);
+
+        u32 clipped = 0;
+        for (u32 i = 0; i < COUNT; i++)
+        {
+            expected_flags[i] = mtx44_project_point(&proj, &viewport, &points[i], &expected[i]);
+            if (expected_flags[i] != 0) clipped++;
+        }
+        CHECK(clipped > 0);
+        CHECK(clipped < COUNT);
+
+        mtx44_project_points(&proj, &viewport, points, result, result_flags, COUNT);
+        REQUIRE(memcmp(result, expected, sizeof(result)) == 0);
+        REQUIRE(memcmp(result_flags, expected_flags, sizeof(result_flags)) == 0);
+
+        mtx44_project_points(&proj, &viewport, points, points, result_flags, COUNT);
+        REQUIRE(memcmp(points, expected, sizeof(points)) == 0);
+    }
+}
+
+TEST_CASE("mtx_mult_batch() and mtx_mult_batch_indexed()", "[mathutil]")
+{
+    constexpr u32 COUNT = 9;
+    Mtx parents[3], children[COUNT], out_mtxs[COUNT], expected[COUNT];
+    u32 parent_idxs[COUNT];
+
+    for (u32 i = 0; i < 3; i++)
+    {
+        load_dummy_mtxa();
+        mtxa_rotate_y(i * 0x2345);
+        mtxa_translate_xyz(i * 2.f, -3.f, 0.5f);
+        mtxa_to_mtx(&parents[i]);
+    }
+    for (u32 i = 0; i < COUNT; i++)
+    {
+        Vec3f pos = {i * 1.5f, 2.f, i * -0.75f};
+        Vec3s rot = {(s16) (i * 0x1111), (s16) (i * -0x0777), (s16) (i * 0x2323)};
+        Vec3f scale = {1.f, 0.5f + i, 2.f};
+        mtx_from_trs(&children[i], &pos, &rot, &scale, EULER_ORDER_ZYX);
+        parent_idxs[i] = (i * 7) % 3;
+    }
+
+    for (u32 i = 0; i < COUNT; i++) mtx_mult(&parents[0], &children[i], &expected[i]);
+    mtx_mult_batch(&parents[0], children, out_mtxs, COUNT);
+    REQUIRE(memcmp(out_mtxs, expected, sizeof(expected)) == 0);
+
+    for (u32 i = 0; i < COUNT; i++) mtx_mult(&parents[parent_idxs[i]], &children[i], &expected[i]);
+    mtx_mult_batch_indexed(parents, parent_idxs, children, out_mtxs, COUNT);
+    REQUIRE(memcmp(out_mtxs, expected, sizeof(expected)) == 0);
+
+    // In place
+    mtx_mult_batch_indexed(parents, parent_idxs, children, children, COUNT);
+    REQUIRE(memcmp(children, expected, sizeof(expected)) == 0);
+}
+
 TEST_CASE("mtxa_from_rotate_x()", "[mathutil]")
 {
     load_dummy_mtxa();
@@ -528,6 +1144,108 @@ TEST_CASE("mtx stack", "[mathlib]")
     check_mtxa(third_pop);
 }
 
+/*
+ * A mix of Matrix A operations, reads, and overwrites, recording everything observable into `out_vecs`/`out_mtxs`.
+ */
+static void run_mtxa_script(Vec3f *out_vecs, Mtx *out_mtxs)
+{
+    Vec3f point = {1.5f, -2.25f, 3.125f};
+    Vec3f scale = {1.5f, 0.75f, 2.f};
+    Vec3s rot;
+    Mtx mtx;
+
+    mtxa_from_identity();
+    mtxa_translate_xyz(10.f, -4.f, 2.5f);
+    mtxa_rotate_y(0x1234);
+    mtxa_rotate_x(-0x2a00);
+    mtxa_scale(&scale);
+    mtxa_tf_point(&point, &out_vecs[0]);
+    mtxa_tf_vec(&point, &out_vecs[1]);
+
+    // More operations than fit in the buffer
+    for (s32 i = 0; i < 40; i++)
+    {
+        mtxa_rotate_z(i * 0x321);
+        mtxa_translate_neg_xyz(0.1f * i, 0.2f, -0.3f);
+        if (i % 7 == 0) mtxa_scale_s(1.01f);
+    }
+    mtxa_to_mtx(&out_mtxs[0]);
+
+    mtxa_push();
+    mtxa_translate(&point);
+    mtxa_rotate_x(0x4000);
+    mtxa_to_mtxb();
+    mtxa_pop();
+    mtxa_rotate_y(0x777);
+    mtxa_push();
+    mtxa_rotate_z(0x100);
+    mtxa_peek();
+    mtxa_to_mtx(&out_mtxs[1]);
+    mtxa_pop();
+
+    // Pending operations followed by functions which overwrite Matrix A
+    mtxa_rotate_x(0x1000);
+    mtxa_from_mtxb();
+    mtxa_translate_neg(&point);
+    mtxa_mult_right(&out_mtxs[0]);
+    mtxa_rotate_z(-0x3000);
+    mtxa_invert();
+    mtxa_rigid_inv_tf_point(&point, &out_vecs[2]);
+    mtxa_scale_xyz(2.f, 2.f, 2.f);
+    mtxa_tf_points(&point, &out_vecs[3], 1);
+    mtxa_to_mtx(&out_mtxs[2]);
+
+    mtxa_from_rotate_y(0x2345);
+    mtxa_rotate_x(0x1111);
+    mtxa_rotate_z(0x0f00);
+    mtxa_to_euler(&rot);
+    out_vecs[4] = {(f32) rot.x, (f32) rot.y, (f32) rot.z};
+    mtxa_translate_xyz(1.f, 2.f, 3.f);
+    mtxa_sq_to_mtx(&mtx);
+    mtxa_rigid_inv_tf_tl(&out_vecs[5]);
+    mtxa_rotate_y(0x0800);
+    mtxa_sq_from_mtx(&mtx);
+    mtxa_to_mtx(&out_mtxs[3]);
+}
+
+TEST_CASE("deferred Matrix A matches eager evaluation", "[mathutil]")
+{
+    Vec3f eager_vecs[6], deferred_vecs[6];
+    Mtx eager_mtxs[4], deferred_mtxs[4];
+    Mtx eager_mtxb;
+
+    run_mtxa_script(eager_vecs, eager_mtxs);
+    memcpy(eager_mtxb, gs->mtxb_raw, sizeof(Mtx));
+
+    mtxa_set_deferred(true);
+    run_mtxa_script(deferred_vecs, deferred_mtxs);
+    REQUIRE(memcmp(eager_vecs, deferred_vecs, sizeof(eager_vecs)) == 0);
+    REQUIRE(memcmp(eager_mtxs, deferred_mtxs, sizeof(eager_mtxs)) == 0);
+    REQUIRE(memcmp(eager_mtxb, gs->mtxb_raw, sizeof(Mtx)) == 0);
+
+    // Operations stay pending until flushed
+    mtxa_rotate_x(0x1234);
+    mtxa_translate_xyz(1.f, 2.f, 3.f);
+    REQUIRE(memcmp(gs->mtxa, &eager_mtxs[3], sizeof(Mtx)) == 0);
+    mtxa_flush();
+    mtxa_set_deferred(false);
+    Mtx deferred_result;
+    memcpy(deferred_result, gs->mtxa, sizeof(Mtx));
+
+    mtxa_from_mtx(&eager_mtxs[3]);
+    mtxa_rotate_x(0x1234);
+    mtxa_translate_xyz(1.f, 2.f, 3.f);
+    REQUIRE(memcmp(gs->mtxa, deferred_result, sizeof(Mtx)) == 0);
+
+    // Disabling deferred mode applies pending operations
+    mtxa_set_deferred(true);
+    mtxa_from_mtx(&eager_mtxs[3]);
+    mtxa_rotate_x(0x1234);
+    mtxa_translate_xyz(1.f, 2.f, 3.f);
+    mtxa_set_deferred(false);
+    REQUIRE(memcmp(gs->mtxa, deferred_result, sizeof(Mtx)) == 0);
+}
+
 TEST_CASE("mtx square copying", "[mathutil]")
 {
     Ufmtx expected;
@@ -620,6 +1338,27 @@ TEST_CASE("mtxa_invert()", "[mathutil]")
     check_mtxa(mtx);
 }
 
+TEST_CASE("mtxa_rigid_invert() and mtxa_uniform_scale_invert()", "[mathutil]")
+{
+    Mtx expected;
+
+    load_dummy_mtxa();
+    mtxa_invert();
+    mtxa_to_mtx(&expected);
+    load_dummy_mtxa();
+    mtxa_rigid_invert();
+    check_mtx(&gs->mtxa_raw, &expected);
+
+    load_dummy_mtxa();
+    mtxa_scale_s(2.5f);
+    mtxa_invert();
+    mtxa_to_mtx(&expected);
+    load_dummy_mtxa();
+    mtxa_scale_s(2.5f);
+    mtxa_uniform_scale_invert();
+    check_mtx(&gs->mtxa_raw, &expected);
+}
+
 TEST_CASE("mtxa_transpose()", "[mathutil]")
 {
     load_dummy_mtxa();
@@ -720,6 +1459,32 @@ TEST_CASE("math mtxa tfset", "[mathutil]")
     check_mtxa(expected);
 }
 
+TEST_CASE("mtxa_tf_points() and mtxa_tf_vecs()", "[mathutil]")
+{
+    // Odd count to cover the non-SIMD remainder
+    constexpr u32 COUNT = 37;
+    Vec3f src[COUNT], batch[COUNT], expected[COUNT];
+    gen_test_vecs(src, COUNT, 100.f);
+    load_dummy_mtxa();
+
+    for (u32 i = 0; i < COUNT; i++) mtxa_tf_point(&src[i], &expected[i]);
+    mtxa_tf_points(src, batch, COUNT);
+    CHECK(memcmp(batch, expected, sizeof(batch)) == 0);
+
+    // In-place
+    memcpy(batch, src, sizeof(batch));
+    mtxa_tf_points(batch, batch, COUNT);
+    CHECK(memcmp(batch, expected, sizeof(batch)) == 0);
+
+    for (u32 i = 0; i < COUNT; i++) mtxa_tf_vec(&src[i], &expected[i]);
+    mtxa_tf_vecs(src, batch, COUNT);
+    CHECK(memcmp(batch, expected, sizeof(batch)) == 0);
+
+    memcpy(batch, src, sizeof(batch));
+    mtxa_tf_vecs(batch, batch, COUNT);
+    CHECK(memcmp(batch, expected, sizeof(batch)) == 0);
+}
+
 TEST_CASE("mtxa_scale_xyz*()", "[mathutil]")
 {
     Ufmtx expected;
@@ -785,6 +1550,120 @@ TEST_CASE("math_mtxa_rigid_inv_tf*()", "[mathutil]")
     check_vec3f(&dst.f, &expected.f);
 }
 
+TEST_CASE("mtxa_rigid_inv_tf_points() and mtxa_rigid_inv_tf_vecs()", "[mathutil]")
+{
+    constexpr u32 COUNT = 37;
+    Vec3f src[COUNT], batch[COUNT], expected[COUNT];
+    gen_test_vecs(src, COUNT, 100.f);
+    load_dummy_mtxa();
+
+    for (u32 i = 0; i < COUNT; i++) mtxa_rigid_inv_tf_point(&src[i], &expected[i]);
+    mtxa_rigid_inv_tf_points(src, batch, COUNT);
+    CHECK(memcmp(batch, expected, sizeof(batch)) == 0);
+
+    memcpy(batch, src, sizeof(batch));
+    mtxa_rigid_inv_tf_points(batch, batch, COUNT);
+    CHECK(memcmp(batch, expected, sizeof(batch)) == 0);
+
+    for (u32 i = 0; i < COUNT; i++) mtxa_rigid_inv_tf_vec(&src[i], &expected[i]);
+    mtxa_rigid_inv_tf_vecs(src, batch, COUNT);
+    CHECK(memcmp(batch, expected, sizeof(batch)) == 0);
+
+    memcpy(batch, src, sizeof(batch));
+    mtxa_rigid_inv_tf_vecs(batch, batch, COUNT);
+    CHECK(memcmp(batch, expected, sizeof(batch)) == 0);
+}
+
+TEST_CASE("aligned type overloads match the Vec3f and Mtx versions", "[mathutil]")
+{
+    REQUIRE(reinterpret_cast<uintptr_t>(&gs->mtxa_raw) % 16 == 0);
+    REQUIRE(reinterpret_cast<uintptr_t>(&gs->mtxb_raw) % 16 == 0);
+    REQUIRE(reinterpret_cast<uintptr_t>(gs->mtx_stack) % 16 == 0);
+
+    constexpr u32 COUNT = 13;
+    Vec3f src[COUNT], expected[COUNT];
+    Vec3fA src_a[COUNT], result_a[COUNT];
+    gen_test_vecs(src, COUNT, 100.f);
+    src[1] = {0.f, -0.f, 0.f};
+    for (u32 i = 0; i < COUNT; i++) src_a[i] = vec3fa_from_vec3f(&src[i]);
+    load_dummy_mtxa();
+
+    auto check_vecs = [&](u32 count) {
+        for (u32 i = 0; i < count; i++)
+        {
+            Vec3f result = vec3fa_to_vec3f(&result_a[i]);
+            REQUIRE(memcmp(&result, &expected[i], sizeof(Vec3f)) == 0);
+        }
+    };
+
+    SECTION("transforms")
+    {
+        for (u32 i = 0; i < COUNT; i++) mtxa_tf_point(&src[i], &expected[i]);
+        mtxa_tf_points(src_a, result_a, COUNT);
+        check_vecs(COUNT);
+        mtxa_tf_point(&src_a[0], &result_a[0]);
+        check_vecs(1);
+
+        for (u32 i = 0; i < COUNT; i++) mtxa_tf_vec(&src[i], &expected[i]);
+        mtxa_tf_vecs(src_a, result_a, COUNT);
+        check_vecs(COUNT);
+        mtxa_tf_vec(&src_a[0], &result_a[0]);
+        check_vecs(1);
+
+        for (u32 i = 0; i < COUNT; i++)
+        {
+            mtxa_rigid_inv_tf_point(&src[i], &expected[i]);
+            mtxa_rigid_inv_tf_point(&src_a[i], &result_a[i]);
+        }
+        check_vecs(COUNT);
+
+        for (u32 i = 0; i < COUNT; i++)
+        {
+            mtxa_rigid_inv_tf_vec(&src[i], &expected[i]);
+            mtxa_rigid_inv_tf_vec(&src_a[i], &result_a[i]);
+        }
+        check_vecs(COUNT);
+
+        // In-place
+        memcpy(result_a, src_a, sizeof(src_a));
+        for (u32 i = 0; i < COUNT; i++) mtxa_tf_point(&src[i], &expected[i]);
+        mtxa_tf_points(result_a, result_a, COUNT);
+        check_vecs(COUNT);
+    }
+
+    SECTION("matrices")
+    {
+        Mtx mtx1, mtx2, expected_mtx;
+        AlignedMtx mtx1_a, mtx2_a, result_a_mtx;
+        mtxa_to_mtx(&mtx1);
+        mtxa_to_mtx(&mtx1_a);
+        REQUIRE(memcmp(mtx1_a.m, mtx1, sizeof(Mtx)) == 0);
+
+        mtxa_rotate_y(0x1234);
+        mtxa_scale_xyz(2.f, -0.5f, 3.f);
+        mtxa_to_mtx(&mtx2);
+        mtx_copy(&mtx2, &mtx2_a.m);
+
+        mtx_mult(&mtx1, &mtx2, &expected_mtx);
+        mtx_mult(&mtx1_a, &mtx2_a, &result_a_mtx);
+        REQUIRE(memcmp(result_a_mtx.m, expected_mtx, sizeof(Mtx)) == 0);
+
+        mtxa_from_mtx(&mtx1);
+        mtxa_mult_right(&mtx2);
+        mtxa_to_mtx(&expected_mtx);
+        mtxa_from_mtx(&mtx1_a);
+        mtxa_mult_right(&mtx2_a);
+        REQUIRE(memcmp(gs->mtxa_raw, expected_mtx, sizeof(Mtx)) == 0);
+
+        mtxa_from_mtx(&mtx1);
+        mtxa_mult_left(&mtx2);
+        mtxa_to_mtx(&expected_mtx);
+        mtxa_from_mtx(&mtx1_a);
+        mtxa_mult_left(&mtx2_a);
+        REQUIRE(memcmp(gs->mtxa_raw, expected_mtx, sizeof(Mtx)) == 0);
+    }
+}
+
 TEST_CASE("inverse rotation mtx equals inverse mtx", "[mathutil]")
 {
     mtxa_from_translate_xyz(0.1f, -4.2f, 7.5f);
@@ -889,8 +1768,141 @@ TEST_CASE("quat_from_dirs()", "[mathutil]")
     expected = {0xbe7b50e0, 0x3e1f7755, 0x3de1634a, 0x3f735258};
     check_quat(&q1.f, &expected.f);
 
-    // TODO SMB's function has peculiar behavior when you pass it non-normalized vectors which we don't account for here.
-    // Fix this and test it here
+    // Non-normalized vectors only contribute their directions
+    vec1.f = VEC_SCALE(3.5f, vec1.f);
+    vec2.f = VEC_SCALE(0.01f, vec2.f);
+    quat_from_dirs(&q1.f, &vec1.f, &vec2.f);
+    check_quat(&q1.f, &expected.f);
+
+    // Identical directions give the identity rotation
+    Quat identity = {0.f, 0.f, 0.f, 1.f};
+    quat_from_dirs(&q1.f, &vec1.f, &vec1.f);
+    check_quat(&q1.f, &identity);
+
+    // Zero-length input gives the identity rotation
+    Vec3f zero = VEC_ZERO;
+    quat_from_dirs(&q1.f, &zero, &vec1.f);
+    check_quat(&q1.f, &identity);
+}
+
+TEST_CASE("quat_from_dirs() with opposite directions", "[mathutil]")
+{
+    Vec3f vecs[16];
+    gen_test_vecs(vecs, 16, 10.f);
+    vecs[0] = {1.f, 0.f, 0.f};
+    vecs[1] = {0.f, 1.f, 0.f};
+    vecs[2] = {0.f, 0.f, -1.f};
+
+    for (Vec3f &start : vecs)
+    {
+        Vec3f end = VEC_SCALE(-2.f, start);
+        Quat q;
+        quat_from_dirs(&q, &start, &end);
+
+        // A unit quaternion rotating by 180 degrees about an axis perpendicular to `start`
+        REQUIRE(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w == Approx(1.f));
+        REQUIRE(q.w == 0.f);
+        REQUIRE(q.x * start.x + q.y * start.y + q.z * start.z == Approx(0.f).margin(1e-5));
+
+        // ...which maps `start` onto the direction of `end`
+        Vec3f rotated;
+        mtxa_from_quat(&q);
+        mtxa_tf_vec(&start, &rotated);
+        REQUIRE(rotated.x == Approx(-start.x).margin(1e-4));
+        REQUIRE(rotated.y == Approx(-start.y).margin(1e-4));
+        REQUIRE(rotated.z == Approx(-start.z).margin(1e-4));
+    }
+}
+
+void gen_test_quats(Quat *quats, u32 count)
+{
+    Vec3f *vecs = new Vec3f[count * 2];
+    gen_test_vecs(vecs, count * 2, 1.f);
+    for (u32 i = 0; i < count; i++)
+    {
+        quats[i] = {vecs[i * 2].x, vecs[i * 2].y, vecs[i * 2].z, vecs[i * 2 + 1].x};
+        quat_normalize(&quats[i]);
+    }
+    delete[] vecs;
+}
+
+TEST_CASE("batched quaternion functions match their scalar counterparts", "[mathutil]")
+{
+    constexpr u32 COUNT = 39;
+    Quat quats1[COUNT], quats2[COUNT], expected[COUNT], result[COUNT];
+    gen_test_quats(quats1, COUNT);
+    gen_test_quats(quats2, COUNT);
+    std::rotate(quats2, quats2 + 5, quats2 + COUNT);
+
+    // Cover nearly identical, identical, and opposite-hemisphere pairs
+    quats2[0] = quats1[0];
+    quats2[1] = {-quats1[1].x, -quats1[1].y, -quats1[1].z, -quats1[1].w};
+    quats2[2] = {quats1[2].x + 1e-7f, quats1[2].y, quats1[2].z, quats1[2].w};
+    quats2[6] = {-quats2[6].x, -quats2[6].y, -quats2[6].z, -quats2[6].w};
+
+    SECTION("quat_mult_batch()")
+    {
+        for (u32 i = 0; i < COUNT; i++) quat_mult(&expected[i], &quats1[i], &quats2[i]);
+        quat_mult_batch(result, quats1, quats2, COUNT);
+        REQUIRE(memcmp(result, expected, sizeof(expected)) == 0);
+
+        quat_mult_batch(quats1, quats1, quats2, COUNT);
+        REQUIRE(memcmp(quats1, expected, sizeof(expected)) == 0);
+    }
+
+    SECTION("quat_normalize_batch()")
+    {
+        for (u32 i = 0; i < COUNT; i++)
+        {
+            quats1[i] = {quats1[i].x * i, quats1[i].y * i, quats1[i].z * i, quats1[i].w * i};
+            expected[i] = quats1[i];
+            quat_normalize(&expected[i]);
+        }
+        quat_normalize_batch(quats1, COUNT);
+        REQUIRE(memcmp(quats1, expected, sizeof(expected)) == 0);
+    }
+
+    SECTION("quat_slerp_batch()")
+    {
+        for (f32 t : {0.f, 0.3f, 0.5f, 0.875f, 1.f})
+        {
+            for (u32 i = 0; i < COUNT; i++) quat_slerp(t, &expected[i], &quats1[i], &quats2[i]);
+            quat_slerp_batch(t, result, quats1, quats2, COUNT, SLERP_EXACT);
+            REQUIRE(memcmp(result, expected, sizeof(expected)) == 0);
+
+            for (u32 i = 0; i < COUNT; i++) quat_nlerp(t, &expected[i], &quats1[i], &quats2[i]);
+            quat_slerp_batch(t, result, quats1, quats2, COUNT, SLERP_FAST);
+            REQUIRE(memcmp(result, expected, sizeof(expected)) == 0);
+
+            // Nlerp stays close to slerp, and matches it at the endpoints
+            f32 margin = (t == 0.f || t == 1.f) ? 1e-6f : 0.1f;
+            for (u32 i = 0; i < COUNT; i++)
+            {
+                Quat slerped;
+                quat_slerp(t, &slerped, &quats1[i], &quats2[i]);
+                REQUIRE(result[i].x == Approx(slerped.x).margin(margin));
+                REQUIRE(result[i].y == Approx(slerped.y).margin(margin));
+                REQUIRE(result[i].z == Approx(slerped.z).margin(margin));
+                REQUIRE(result[i].w == Approx(slerped.w).margin(margin));
+            }
+        }
+    }
+
+    SECTION("mtx_from_quat_batch()")
+    {
+        Mtx expected_mtxs[COUNT], result_mtxs[COUNT];
+        for (u32 i = 0; i < COUNT; i++)
+        {
+            mtxa_from_quat(&quats1[i]);
+            mtxa_to_mtx(&expected_mtxs[i]);
+        }
+        load_dummy_mtxa();
+        Mtx dummy;
+        mtxa_to_mtx(&dummy);
+        mtx_from_quat_batch(quats1, result_mtxs, COUNT);
+        REQUIRE(memcmp(result_mtxs, expected_mtxs, sizeof(expected_mtxs)) == 0);
+        REQUIRE(memcmp(&gs->mtxa_raw, &dummy, sizeof(Mtx)) == 0);
+    }
 }
 
 TEST_CASE("quat_slerp()", "[mathutil]")
@@ -963,3 +1975,68 @@ TEST_CASE("mtxa_to_euler*()", "[mathutil]")
     CHECK(abs(rot.y - expected.y) <= 1);
     CHECK(abs(rot.z - expected.z) <= 1);
 }
+
+/*
+ * The original game's `mtxa_to_euler_yxz()`, which undoes the Y and X rotations on the up vector with a rotation
+ * matrix built in Matrix A.
+ */
+static void legacy_mtxa_to_euler_yxz(s16 *out_rot_y, s16 *out_rot_x, s16 *out_rot_z)
+{
+    mtxa_push();
+
+    Vec3f forward = {0.f, 0.f, -1.f};
+    Vec3f up = {0.f, 1.f, 0.f};
+    mtxa_tf_vec(&forward, &forward);
+    mtxa_tf_vec(&up, &up);
+
+    f32 forward_len2d = math_sqrt(forward.x * forward.x + forward.z * forward.z);
+    *out_rot_x = math_atan2(forward.y, forward_len2d);
+    *out_rot_y = math_atan2(forward.x, forward.z) + 0x8000;
+
+    mtxa_from_rotate_y(*out_rot_y);
+    mtxa_rotate_x(*out_rot_x);
+    mtxa_rigid_inv_tf_vec(&up, &up);
+    *out_rot_z = -math_atan2(up.x, up.y);
+
+    mtxa_pop();
+}
+
+TEST_CASE("mtxa_to_euler_yxz() and mtx_to_euler_batch() match the original algorithm", "[mathutil]")
+{
+    constexpr u32 COUNT = 300;
+    Quat quats[COUNT];
+    Vec3f scales[COUNT];
+    Mtx mtxs[COUNT];
+    Vec3s expected[COUNT], result[COUNT];
+    gen_test_quats(quats, COUNT);
+    gen_test_vecs(scales, COUNT, 2.f);
+
+    for (u32 i = 0; i < COUNT; i++)
+    {
+        if (i < 100)
+        {
+            mtxa_from_quat(&quats[i]);
+        }
+        else
+        {
+            // Exact Euler rotations, including straight up and down and some non-rigid matrices
+            mtxa_from_identity();
+            mtxa_rotate_y(i * 0x1d3);
+            mtxa_rotate_x(i % 3 == 0 ? (i % 2 ? 0x4000 : -0x4000) : i * 0x2f1);
+            mtxa_rotate_z(i * 0x3b7);
+            if (i >= 200) mtxa_scale(&scales[i]);
+        }
+        mtxa_to_mtx(&mtxs[i]);
+
+        legacy_mtxa_to_euler_yxz(&expected[i].y, &expected[i].x, &expected[i].z);
+        Vec3s rot;
+        mtxa_to_euler_yxz(&rot.y, &rot.x, &rot.z);
+        REQUIRE(rot.x == expected[i].x);
+        REQUIRE(rot.y == expected[i].y);
+        REQUIRE(rot.z == expected[i].z);
+        REQUIRE(memcmp(gs->mtxa, &mtxs[i], sizeof(Mtx)) == 0);
+    }
+
+    mtx_to_euler_batch(mtxs, result, COUNT);
+    REQUIRE(memcmp(result, expected, sizeof(expected)) == 0);
+}
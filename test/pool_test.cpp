@@ -0,0 +1,526 @@
+#include <catch.hpp>
+
+#include <cstring>
+#include <type_traits>
+
+#include "pool.h"
+#include "global_state.h"
+#include "test_rand.h"
+
+using namespace mkb2;
+
+/*
+ * The original game's `pool_alloc()`, which searches the status list one slot at a time and writes it directly.
+ */
+static s32 legacy_pool_alloc(PoolInfo *info, u8 status)
+{
+    for (u32 i = 0; i < info->len; i++)
+    {
+        if (info->status_list[i] == 0)
+        {
+            if (info->upper_bound < i + 1) info->upper_bound = i + 1;
+            info->low_free_idx = i + 1;
+
+            ((u8 *) info->status_list)[i] = status;
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+ * The original game's per-frame pool metadata refresh.
+ */
+static void legacy_pool_update_idxs(PoolInfo *info)
+{
+    s32 new_low_free_idx = -1;
+    u32 new_upper_bound = 0;
+    for (u32 i = 0; i < info->len; i++)
+    {
+        if (info->status_list[i] == 0)
+        {
+            if (new_low_free_idx == -1) new_low_free_idx = i;
+        }
+        else
+        {
+            new_upper_bound = i + 1;
+        }
+    }
+    info->low_free_idx = new_low_free_idx == -1 ? 0 : new_low_free_idx;
+    info->upper_bound = new_upper_bound;
+}
+
+static void check_pools_match(PoolInfo *info, PoolInfo *legacy_info)
+{
+    REQUIRE(info->low_free_idx == legacy_info->low_free_idx);
+    REQUIRE(info->upper_bound == legacy_info->upper_bound);
+    REQUIRE(memcmp(info->status_list, legacy_info->status_list, info->len) == 0);
+}
+
+TEST_CASE("pool_alloc() and pool_tick() match the original game", "[pool]")
+{
+    pool_init();
+    gs->events[EVENT_EFFECT].status = STAT_NORMAL;
+
+    PoolInfo *info = gs->effect_pool.info();
+    static u8 legacy_status_list[MAX_EFFECTS];
+    PoolInfo legacy_info = {MAX_EFFECTS, 0, 0, legacy_status_list, nullptr, 0, 0};
+    memset(legacy_status_list, 0, sizeof(legacy_status_list));
+
+    u32 state = 0x1234567;
+    for (u32 step = 0; step < 20000; step++)
+    {
+        u32 action = test_rand(state) % 16;
+        if (action < 9)
+        {
+            // Status 0 "allocates" a slot which stays free
+            u8 status = test_rand(state) % 6;
+            REQUIRE(pool_alloc(info, status) == legacy_pool_alloc(&legacy_info, status));
+        }
+        else if (action < 13)
+        {
+            u32 idx = test_rand(state) % MAX_EFFECTS;
+            pool_free(info, idx);
+            legacy_status_list[idx] = 0;
+        }
+        else if (action < 15)
+        {
+            u32 idx = test_rand(state) % MAX_EFFECTS;
+            u8 status = test_rand(state) % 4;
+            pool_set_status(info, idx, status);
+            legacy_status_list[idx] = status;
+        }
+        else
+        {
+            pool_tick();
+            legacy_pool_update_idxs(&legacy_info);
+        }
+        check_pools_match(info, &legacy_info);
+
+        // The lowest free slot and live end are kept up to date on every change, not just on `pool_tick()`
+        PoolInfo scanned_info = legacy_info;
+        legacy_pool_update_idxs(&scanned_info);
+        REQUIRE((info->lowest_free == MAX_EFFECTS ? 0 : info->lowest_free) == scanned_info.low_free_idx);
+        REQUIRE(info->live_end == scanned_info.upper_bound);
+    }
+
+    gs->events[EVENT_EFFECT].status = STAT_NULL;
+}
+
+TEST_CASE("pool_alloc() on a full pool", "[pool]")
+{
+    pool_init();
+    PoolInfo *info = gs->camera_pool.info();
+
+    for (u32 i = 0; i < MAX_CAMERAS; i++) REQUIRE(pool_alloc(info, STAT_NORMAL) == (s32) i);
+    REQUIRE(pool_alloc(info, STAT_NORMAL) == -1);
+    REQUIRE(info->upper_bound == MAX_CAMERAS);
+
+    pool_free(info, 2);
+    REQUIRE(pool_alloc(info, STAT_INIT) == 2);
+    REQUIRE(info->status_list[2] == STAT_INIT);
+    REQUIRE(pool_alloc(info, STAT_NORMAL) == -1);
+
+    pool_clear(info);
+    REQUIRE(pool_alloc(info, STAT_NORMAL) == 0);
+}
+
+TEST_CASE("pool_tick() of inactive, empty, and full pools", "[pool]")
+{
+    pool_init();
+    gs->events[EVENT_ITEM].status = STAT_NORMAL;
+    gs->events[EVENT_STOBJ].status = STAT_NULL;
+
+    for (u32 i = 0; i < MAX_ITEMS; i++) pool_alloc(gs->item_pool.info(), STAT_NORMAL);
+    pool_alloc(gs->stobj_pool.info(), STAT_NORMAL);
+    pool_alloc(gs->stobj_pool.info(), STAT_NORMAL);
+    pool_tick();
+
+    // Full
+    REQUIRE(gs->item_pool.pool_info.low_free_idx == 0);
+    REQUIRE(gs->item_pool.pool_info.upper_bound == MAX_ITEMS);
+
+    // The stobj event isn't running
+    REQUIRE(gs->stobj_pool.pool_info.low_free_idx == 0);
+    REQUIRE(gs->stobj_pool.pool_info.upper_bound == 0);
+
+    // Empty
+    REQUIRE(gs->ball_pool.pool_info.low_free_idx == 0);
+    REQUIRE(gs->ball_pool.pool_info.upper_bound == 0);
+
+    // Last slot of a pool whose length isn't a multiple of 64 (144)
+    gs->events[EVENT_STOBJ].status = STAT_NORMAL;
+    pool_set_status(gs->stobj_pool.info(), MAX_STOBJS - 1, STAT_INIT);
+    pool_tick();
+    REQUIRE(gs->stobj_pool.pool_info.low_free_idx == 2);
+    REQUIRE(gs->stobj_pool.pool_info.upper_bound == MAX_STOBJS);
+
+    pool_free(gs->item_pool.info(), 200);
+    pool_free(gs->item_pool.info(), 255);
+    pool_tick();
+    REQUIRE(gs->item_pool.pool_info.low_free_idx == 200);
+    REQUIRE(gs->item_pool.pool_info.upper_bound == 255);
+
+    gs->events[EVENT_ITEM].status = STAT_NULL;
+    gs->events[EVENT_STOBJ].status = STAT_NULL;
+}
+
+TEST_CASE("pool_for_each_live()", "[pool]")
+{
+    pool_init();
+    PoolInfo *info = gs->stobj_pool.info();
+
+    u32 count = 0;
+    pool_for_each_live(info, [&](u32) { count++; });
+    REQUIRE(count == 0);
+
+    // Random statuses, covering the last partial bitmap word (MAX_STOBJS = 144)
+    u32 state = 0x1234567;
+    for (u32 i = 0; i < MAX_STOBJS; i++) pool_set_status(info, i, test_rand(state) % 3);
+    pool_set_status(info, 0, STAT_NORMAL);
+    pool_set_status(info, MAX_STOBJS - 1, STAT_NORMAL);
+
+    u32 idxs[MAX_STOBJS];
+    count = 0;
+    pool_for_each_live(info, [&](u32 idx) { idxs[count++] = idx; });
+
+    u32 expected_count = 0;
+    for (u32 i = 0; i < MAX_STOBJS; i++)
+    {
+        if (info->status_list[i] != 0)
+        {
+            REQUIRE(expected_count < count);
+            REQUIRE(idxs[expected_count] == i);
+            expected_count++;
+        }
+    }
+    REQUIRE(count == expected_count);
+
+    // Freeing the visited object while walking
+    pool_for_each_live(info, [&](u32 idx) { pool_free(info, idx); });
+    count = 0;
+    pool_for_each_live(info, [&](u32) { count++; });
+    REQUIRE(count == 0);
+}
+
+TEST_CASE("Pool<T, N>", "[pool]")
+{
+    struct TestObj
+    {
+        u32 val;
+    };
+    static Pool<TestObj, 100> pool;
+    static_assert(std::is_trivially_copyable<Pool<TestObj, 100>>::value, "Pools must be trivially copyable");
+    // GlobalState must be copied with `global_state_snapshot()` since its pools live in its arena, which a plain copy
+    // doesn't include
+    static_assert(std::is_trivially_copyable<GlobalState>::value, "GlobalState must be trivially copyable");
+    static_assert(std::is_same<decltype(PoolInfo::status_list), const u8 *>::value,
+                  "Statuses must only be changed through the pool functions");
+
+    pool.init();
+    for (u32 i = 0; i < 100; i++)
+    {
+        REQUIRE(pool.alloc(STAT_NORMAL) == (s32) i);
+        pool[i].val = i * 10;
+    }
+    for (u32 i = 0; i < 100; i += 3) pool.free(i);
+    pool.set_status(99, STAT_INIT);
+    REQUIRE(pool.alloc(STAT_NORMAL) == 0);
+
+    u32 count = 0;
+    pool.for_each_live([&](u32 idx, TestObj &obj) {
+        REQUIRE(obj.val == idx * 10);
+        REQUIRE((idx == 0 || idx == 99 || idx % 3 != 0));
+        count++;
+    });
+    REQUIRE(count == 68);
+
+    // A copy of the pool is independent of the original
+    static Pool<TestObj, 100> snapshot;
+    memcpy(&snapshot, &pool, sizeof(pool));
+    pool.clear();
+    count = 0;
+    snapshot.for_each_live_idx([&](u32) { count++; });
+    REQUIRE(count == 68);
+    REQUIRE(snapshot.alloc(STAT_NORMAL) == 3);
+    REQUIRE(pool.info()->status_list[3] == 0);
+    REQUIRE(pool.alloc(STAT_NORMAL) == 0);
+}
+
+template <u32 N>
+struct TestMotion
+{
+    Vec3f pos[N];
+    Vec3f vel[N];
+};
+
+TEST_CASE("SoaPool<Fields, N>", "[pool]")
+{
+    static SoaPool<TestMotion, 64> pool;
+    pool.init();
+
+    for (u32 i = 0; i < 10; i++)
+    {
+        s32 idx = pool.alloc(STAT_NORMAL);
+        pool.fields.pos[idx] = {(f32) i, 0.f, 0.f};
+        pool.fields.vel[idx] = {1.f, 2.f, 3.f};
+    }
+    pool.free(4);
+
+    for (u32 i = 0; i < pool.pool_info.upper_bound; i++)
+    {
+        pool.fields.pos[i].x += pool.fields.vel[i].x;
+        pool.fields.pos[i].y += pool.fields.vel[i].y;
+        pool.fields.pos[i].z += pool.fields.vel[i].z;
+    }
+
+    u32 count = 0;
+    pool.for_each_live_idx([&](u32 idx) {
+        REQUIRE(pool.fields.pos[idx].x == idx + 1.f);
+        REQUIRE(pool.fields.pos[idx].z == 3.f);
+        count++;
+    });
+    REQUIRE(count == 9);
+}
+
+TEST_CASE("ArenaPool<T>", "[pool]")
+{
+    struct TestObj
+    {
+        u32 val;
+    };
+    using TestPool = ArenaPool<TestObj>;
+    struct PoolAndArena
+    {
+        TestPool pool;
+        alignas(64) u8 arena[TestPool::arena_size(64)];
+    };
+    static PoolAndArena storage;
+    TestPool &pool = storage.pool;
+    static_assert(sizeof(TestPool) < sizeof(TestObj) * 16, "Arena pools don't store any slots themselves");
+
+    u8 *arena = storage.arena;
+    pool.init(64, &arena, storage.arena + sizeof(storage.arena));
+    REQUIRE(pool.capacity() == 64);
+    REQUIRE(arena == storage.arena + sizeof(storage.arena));
+    REQUIRE((u8 *) pool.obj_list() == storage.arena);
+    for (u32 i = 0; i < 64; i++)
+    {
+        REQUIRE(pool.alloc(STAT_NORMAL) == (s32) i);
+        pool[i].val = i;
+    }
+    REQUIRE(pool.alloc(STAT_NORMAL) == -1);
+
+    pool.free(10);
+    u32 count = 0;
+    pool.for_each_live([&](u32 idx, TestObj &obj) {
+        REQUIRE(obj.val == idx);
+        count++;
+    });
+    REQUIRE(count == 63);
+
+    // An empty pool takes no arena space
+    pool.init(0, &arena, storage.arena + sizeof(storage.arena));
+    REQUIRE(arena == storage.arena + sizeof(storage.arena));
+    REQUIRE(pool.alloc(STAT_NORMAL) == -1);
+}
+
+TEST_CASE("global_state_create() with pool capacities", "[pool]")
+{
+    std::unique_ptr<GlobalState> prev_gs = std::move(gs);
+
+    SECTION("vanilla")
+    {
+        PoolCapacities capacities = VANILLA_POOL_CAPACITIES;
+        gs = global_state_create(capacities);
+        pool_init();
+        REQUIRE(gs->get_pool_arena_size() == pool_arena_size(&capacities));
+        REQUIRE(gs->ball_pool.capacity() == MAX_BALLS);
+        REQUIRE(gs->effect_pool.capacity() == MAX_EFFECTS);
+
+        for (u32 i = 0; i < MAX_BALLS; i++) REQUIRE(gs->ball_pool.alloc(STAT_NORMAL) == (s32) i);
+        REQUIRE(gs->ball_pool.alloc(STAT_NORMAL) == -1);
+    }
+
+    SECTION("10x")
+    {
+        PoolCapacities capacities = {
+            MAX_BALLS * 10, MAX_ITEMS * 10, MAX_STOBJS * 10, MAX_SPRITES * 10, MAX_EFFECTS * 10, MAX_CAMERAS,
+        };
+        gs = global_state_create(capacities);
+        pool_init();
+        REQUIRE(gs->get_pool_capacities().items == MAX_ITEMS * 10);
+        REQUIRE(gs->get_pool_arena_size() == pool_arena_size(&capacities));
+        REQUIRE(gs->item_pool.capacity() == MAX_ITEMS * 10);
+        REQUIRE(gs->camera_pool.capacity() == MAX_CAMERAS);
+
+        // Everything stored in the arena is within its bounds
+        u8 *arena_start = (u8 *) gs.get() + sizeof(GlobalState);
+        u8 *arena_end = arena_start + gs->get_pool_arena_size();
+        REQUIRE((u8 *) gs->effect_pool.obj_list() >= arena_start);
+        REQUIRE(gs->effect_pool.info()->status_list + MAX_EFFECTS * 10 <= arena_end);
+
+        for (u32 i = 0; i < MAX_BALLS * 10; i++) REQUIRE(gs->ball_pool.alloc(STAT_NORMAL) == (s32) i);
+        REQUIRE(gs->ball_pool.alloc(STAT_NORMAL) == -1);
+        for (u32 i = 0; i < MAX_ITEMS * 10; i++) REQUIRE(gs->item_pool.alloc(STAT_NORMAL) == (s32) i);
+        gs->item_pool.free(MAX_ITEMS * 5);
+        gs->events[EVENT_ITEM].status = STAT_NORMAL;
+        pool_tick();
+        REQUIRE(gs->item_pool.pool_info.low_free_idx == MAX_ITEMS * 5);
+        REQUIRE(gs->item_pool.pool_info.upper_bound == MAX_ITEMS * 10);
+
+        // A snapshot of the GlobalState and its arena is independent of the original
+        std::unique_ptr<GlobalState> snapshot = global_state_snapshot(gs.get());
+        REQUIRE(snapshot->mtxa == &snapshot->mtxa_raw);
+        REQUIRE(snapshot->mtx_stack_ptr == snapshot->mtx_stack + MTX_STACK_LEN);
+
+        gs->item_pool.clear();
+        u32 count = 0;
+        snapshot->item_pool.for_each_live_idx([&](u32) { count++; });
+        REQUIRE(count == MAX_ITEMS * 10 - 1);
+        REQUIRE(gs->item_pool.alloc(STAT_NORMAL) == 0);
+
+        REQUIRE(global_state_restore(gs.get(), snapshot.get()));
+        REQUIRE(gs->mtxa == &gs->mtxa_raw);
+        REQUIRE(gs->item_pool.alloc(STAT_NORMAL) == (s32) MAX_ITEMS * 5);
+        REQUIRE(snapshot->item_pool.info()->status_list[0] != 0);
+        REQUIRE(snapshot->item_pool.info()->status_list[MAX_ITEMS * 5] == 0);
+
+        // Only between GlobalStates with the same pool capacities
+        std::unique_ptr<GlobalState> vanilla_gs = global_state_create(VANILLA_POOL_CAPACITIES);
+        REQUIRE(!global_state_restore(vanilla_gs.get(), snapshot.get()));
+
+        gs->events[EVENT_ITEM].status = STAT_NULL;
+    }
+
+    gs = std::move(prev_gs);
+}
+
+TEST_CASE("pool allocation", "[pool][.][benchmark]")
+{
+    pool_init();
+    PoolInfo *info = gs->effect_pool.info();
+    static u8 legacy_status_list[MAX_EFFECTS];
+    PoolInfo legacy_info = {MAX_EFFECTS, 0, 0, legacy_status_list, nullptr, 0, 0};
+
+    // Free every effect after spawning 512 of them in a frame
+    BENCHMARK("allocate and free 512 effects, legacy")
+    {
+        for (u32 i = 0; i < MAX_EFFECTS; i++) legacy_pool_alloc(&legacy_info, STAT_NORMAL);
+        for (u32 i = 0; i < MAX_EFFECTS; i++) legacy_status_list[i] = 0;
+        return legacy_info.upper_bound;
+    };
+    BENCHMARK("allocate and free 512 effects")
+    {
+        for (u32 i = 0; i < MAX_EFFECTS; i++) pool_alloc(info, STAT_NORMAL);
+        for (u32 i = 0; i < MAX_EFFECTS; i++) pool_free(info, i);
+        return info->upper_bound;
+    };
+
+    // A few live objects in each pool, like most frames of the game
+    pool_clear(info);
+    for (u32 i = 0; i < 4; i++)
+    {
+        pool_alloc(gs->ball_pool.info(), STAT_NORMAL);
+        pool_alloc(gs->item_pool.info(), STAT_NORMAL);
+        pool_alloc(gs->stobj_pool.info(), STAT_NORMAL);
+        pool_alloc(gs->sprite_pool.info(), STAT_NORMAL);
+        pool_alloc(gs->effect_pool.info(), STAT_NORMAL);
+        pool_alloc(gs->camera_pool.info(), STAT_NORMAL);
+    }
+    for (EventID event : {EVENT_ITEM, EVENT_STOBJ, EVENT_SPRITE, EVENT_EFFECT, EVENT_CAMERA})
+    {
+        gs->events[event].status = STAT_NORMAL;
+    }
+
+    BENCHMARK("pool_tick(), legacy")
+    {
+        legacy_pool_update_idxs(gs->ball_pool.info());
+        legacy_pool_update_idxs(gs->item_pool.info());
+        legacy_pool_update_idxs(gs->stobj_pool.info());
+        legacy_pool_update_idxs(gs->sprite_pool.info());
+        legacy_pool_update_idxs(gs->effect_pool.info());
+        legacy_pool_update_idxs(gs->camera_pool.info());
+        return gs->effect_pool.pool_info.upper_bound;
+    };
+    BENCHMARK("pool_tick()")
+    {
+        pool_tick();
+        return gs->effect_pool.pool_info.upper_bound;
+    };
+
+    // A handful of bananas near the end of the item pool, as after collecting the rest of a stage's bananas
+    pool_clear(gs->item_pool.info());
+    for (u32 i = 0; i < 8; i++) pool_set_status(gs->item_pool.info(), 100 + i * 19, STAT_NORMAL);
+    pool_tick();
+
+    BENCHMARK("walk live items, status bytes")
+    {
+        const u8 *status_list = gs->item_pool.info()->status_list;
+        u32 idx_sum = 0;
+        for (u32 i = 0; i < gs->item_pool.pool_info.upper_bound; i++)
+        {
+            if (status_list[i] != 0) idx_sum += i;
+        }
+        return idx_sum;
+    };
+    BENCHMARK("walk live items, pool_for_each_live()")
+    {
+        u32 idx_sum = 0;
+        pool_for_each_live(gs->item_pool.info(), [&](u32 idx) { idx_sum += idx; });
+        return idx_sum;
+    };
+
+    for (EventID event : {EVENT_ITEM, EVENT_STOBJ, EVENT_SPRITE, EVENT_EFFECT, EVENT_CAMERA})
+    {
+        gs->events[event].status = STAT_NULL;
+    }
+}
+
+TEST_CASE("pool allocation at 10x capacity", "[pool][.][benchmark]")
+{
+    std::unique_ptr<GlobalState> prev_gs = std::move(gs);
+    PoolCapacities capacities = {
+        MAX_BALLS * 10, MAX_ITEMS * 10, MAX_STOBJS * 10, MAX_SPRITES * 10, MAX_EFFECTS * 10, MAX_CAMERAS * 10,
+    };
+    gs = global_state_create(capacities);
+    pool_init();
+    constexpr u32 EFFECT_COUNT = MAX_EFFECTS * 10;
+    constexpr u32 ITEM_COUNT = MAX_ITEMS * 10;
+
+    BENCHMARK("allocate and free 5120 effects")
+    {
+        for (u32 i = 0; i < EFFECT_COUNT; i++) gs->effect_pool.alloc(STAT_NORMAL);
+        for (u32 i = 0; i < EFFECT_COUNT; i++) gs->effect_pool.free(i);
+        return gs->effect_pool.pool_info.upper_bound;
+    };
+
+    // Every fourth item of a stage with 2560 bananas
+    for (u32 i = 0; i < ITEM_COUNT; i += 4) gs->item_pool.set_status(i, STAT_NORMAL);
+    gs->events[EVENT_ITEM].status = STAT_NORMAL;
+    pool_tick();
+
+    BENCHMARK("pool_tick() with 640 of 2560 items live")
+    {
+        pool_tick();
+        return gs->item_pool.pool_info.upper_bound;
+    };
+    BENCHMARK("walk 640 of 2560 live items, status bytes")
+    {
+        const u8 *status_list = gs->item_pool.info()->status_list;
+        u32 idx_sum = 0;
+        for (u32 i = 0; i < gs->item_pool.pool_info.upper_bound; i++)
+        {
+            if (status_list[i] != 0) idx_sum += i;
+        }
+        return idx_sum;
+    };
+    BENCHMARK("walk 640 of 2560 live items, for_each_live()")
+    {
+        u32 idx_sum = 0;
+        gs->item_pool.for_each_live([&](u32 idx, Item &) { idx_sum += idx; });
+        return idx_sum;
+    };
+
+    gs = std::move(prev_gs);
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include <catch.hpp>
+
+#include "stagedef_mtx.h"
+#include "mathutil.h"
+#include "global_state.h"
+#include "stagedef.h"
+
+using namespace mkb2;
+
+static void check_mtx_approx(Mtx *result, Mtx *expected)
+{
+    for (s32 row = 0; row < 3; row++)
+    {
+        for (s32 col = 0; col < 4; col++)
+        {
+            REQUIRE((*result)[row][col] == Approx((*expected)[row][col]).margin(1e-5));
+        }
+    }
+}
+
+TEST_CASE("stagedef_coli_header_to_world_mtxs()", "[stagedef_mtx]")
+{
+    StagedefBumper bumpers[2] = {};
+    StagedefJamabar jamabars[1] = {};
+    StagedefBanana bananas[3] = {};
+    StagedefConeCollision cones[1] = {};
+    StagedefStageModelInstance instances[2] = {};
+
+    bumpers[0] = {{1.f, 2.f, 3.f}, {0x1000, 0x2000, 0x3000}, {}, {1.f, 1.f, 1.f}};
+    bumpers[1] = {{-4.f, 0.f, 8.f}, {0, -0x4000, 0x0123}, {}, {2.f, 2.f, 2.f}};
+    jamabars[0].position = {0.5f, 0.5f, -0.5f};
+    jamabars[0].rotation = {0x7000, 0, 0};
+    jamabars[0].scale = {1.f, 3.f, 1.f};
+    bananas[0].position = {10.f, 0.f, 0.f};
+    bananas[1].position = {0.f, 10.f, 0.f};
+    bananas[2].position = {0.f, 0.f, 10.f};
+    cones[0] = {{3.f, 3.f, 3.f}, {-0x1234, 0x5678, 0}, {}, {0.5f, 4.f, 0.5f}};
+    instances[0].position = {-1.f, -2.f, -3.f};
+    instances[0].rotation = {0, 0, 0x4000};
+    instances[0].scale = {1.f, 1.f, 1.f};
+    instances[1].position = {6.f, 7.f, 8.f};
+    instances[1].rotation = {0x0100, 0x0200, 0x0300};
+    instances[1].scale = {0.25f, 0.25f, 0.25f};
+
+    StagedefCollisionHeader coli_header = {};
+    coli_header.bumper_count = 2;
+    coli_header.bumper_list = bumpers;
+    coli_header.jamabar_count = 1;
+    coli_header.jamabar_list = jamabars;
+    coli_header.banana_count = 3;
+    coli_header.banana_list = bananas;
+    coli_header.cone_collision_object_count = 1;
+    coli_header.cone_collision_object_list = cones;
+    coli_header.stage_model_instance_count = 2;
+    coli_header.stage_model_instance_list = instances;
+
+    Mtx coli_header_mtx;
+    mtxa_from_translate_xyz(5.f, -1.f, 2.f);
+    mtxa_rotate_y(0x2800);
+    mtxa_rotate_x(-0x0800);
+    mtxa_to_mtx(&coli_header_mtx);
+
+    REQUIRE(stagedef_coli_header_child_count(&coli_header) == 9);
+    Mtx out_mtxs[9];
+    REQUIRE(stagedef_coli_header_to_world_mtxs(&coli_header, &coli_header_mtx, out_mtxs) == 9);
+
+    // Build each expected matrix the way the game would, one chain of Matrix A operations at a time
+    Vec3f positions[9] = {bumpers[0].position, bumpers[1].position, jamabars[0].position, bananas[0].position,
+                          bananas[1].position, bananas[2].position, cones[0].position, instances[0].position,
+                          instances[1].position};
+    Vec3s rotations[9] = {bumpers[0].rotation, bumpers[1].rotation, jamabars[0].rotation, {}, {}, {},
+                          cones[0].rotation, instances[0].rotation, instances[1].rotation};
+    Vec3f scales[9] = {bumpers[0].scale, bumpers[1].scale, jamabars[0].scale, {1.f, 1.f, 1.f}, {1.f, 1.f, 1.f},
+                       {1.f, 1.f, 1.f}, cones[0].scale, instances[0].scale, instances[1].scale};
+    for (u32 i = 0; i < 9; i++)
+    {
+        mtxa_from_mtx(&coli_header_mtx);
+        mtxa_translate(&positions[i]);
+        mtxa_rotate_z(rotations[i].z);
+        mtxa_rotate_y(rotations[i].y);
+        mtxa_rotate_x(rotations[i].x);
+        mtxa_scale(&scales[i]);
+        check_mtx_approx(&out_mtxs[i], &gs->mtxa_raw);
+    }
+}
\ No newline at end of file
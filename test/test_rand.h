@@ -0,0 +1,29 @@
+#pragma once
+
+#include "mathtypes.h"
+
+namespace mkb2
+{
+
+/*
+ * Deterministic pseudo-random numbers for tests and benchmarks, so that failures are reproducible.
+ */
+
+/*
+ * Advance the linear congruential generator `state` and return 24 pseudo-random bits.
+ */
+inline u32 test_rand(u32 &state)
+{
+    state = state * 1664525 + 1013904223;
+    return state >> 8;
+}
+
+/*
+ * Pseudo-random value in [-range, range].
+ */
+inline f32 test_rand_f32(u32 &state, f32 range)
+{
+    return ((f32) test_rand(state) / (1 << 24) * 2.f - 1.f) * range;
+}
+
+}
\ No newline at end of file